@@ -3,6 +3,10 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <memory>
+#include <chrono>
 #include <vector>
 #include <list>
 #include <queue>
@@ -20,42 +24,206 @@ constexpr size_t TOTAL_PAGES = CACHE_SIZE / PAGE_SIZE;
 constexpr int MAX_EVENTS = 64;
 constexpr int BUFFER_SIZE = 4096;
 constexpr int NUM_WORKER_THREADS = 4;
+constexpr size_t BATCH_PREFETCH_GROUP = 16;  // Lookups in flight per prefetch group
+constexpr size_t BATCH_PREFETCH_BYTES = 256; // Leading bytes of each value to prefetch
+constexpr size_t SCRUB_BATCH_PAGES = 64;  // Pages verified per cache lock hold
+constexpr int RELEASE_SCAN_INTERVAL_MS = 1000;  // How often idle free runs are checked
+constexpr size_t MAX_LIFETIME_CLASSES = 4096;  // Key prefixes tracked by the lifetime predictor
+constexpr size_t NT_COPY_THRESHOLD = 256 * 1024; // Values this large bypass the CPU cache on write
+constexpr size_t MAX_FILL_LEASES = 4096;        // Outstanding leases before expired ones are swept
+constexpr size_t HOT_KEY_CAPACITY = 128;        // Counters kept by the heavy-hitter tracker
+constexpr uint64_t REPLICA_REFRESH_ACCESSES = 4096; // Hits between recomputing the replicated set
+constexpr uint64_t REPLICA_FLUSH_HITS = 256;    // Replica hits a thread batches before crediting them
+constexpr size_t MRC_MAX_REFS = 1 << 20;        // Reference slots before the MRC estimator compacts
+constexpr size_t MRC_BUCKETS = 512;             // Reuse distance histogram covers 8x TOTAL_PAGES
+constexpr uint64_t EVICTOR_MAX_BACKOFF_MS = 10000; // Longest wait after a largest-block attempt fails
+
+// Fast 64-bit key hash (wyhash/xxh3-style, AVX2 stripe loop for long keys)
+uint64_t hashKey(const char* data, size_t len);
+
+// CRC32C (Castagnoli), SSE4.2 accelerated with a table-driven fallback
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t len);
+
+// Hasher for the entry index. Deliberately not noexcept: this keeps the
+// hash code cached in every node, so lookups compare it before the key.
+struct KeyHash {
+    size_t operator()(const std::string& key) const {
+        return hashKey(key.data(), key.size());
+    }
+};
 
 // Eviction policies
 enum class EvictionPolicy {
     LRU,
     FIFO,
     SIEVE,
-    CLOCK
+    CLOCK,
+    GDS,    // GreedyDual-Size: evicts the lowest cost per page first
+    GDSF    // GreedyDual-Size-Frequency: GDS weighted by hit count
 };
 
 // Free block in the linked list
 struct FreeBlock {
     size_t start_page;
     size_t num_pages;
+    uint64_t freed_at_ms;  // When pages were last added to this block
     FreeBlock* next;
     FreeBlock* prev;
     
     FreeBlock(size_t start, size_t count) 
-        : start_page(start), num_pages(count), next(nullptr), prev(nullptr) {}
+        : start_page(start), num_pages(count), freed_at_ms(0), next(nullptr), prev(nullptr) {}
 };
 
 // Page structure
 struct Page {
     uint8_t data[PAGE_SIZE];
     bool is_free;
+    bool released;       // Data handed back to the OS with madvise
     size_t block_start;  // Start of the contiguous block this page belongs to
     
-    Page() : is_free(true), block_start(0) {}
+    Page() : is_free(true), released(false), block_start(0) {}
+};
+
+// NUMA node owning a contiguous page arena
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+    size_t first_page;
+    size_t num_pages;
+    size_t active_pages;  // Leading pages in service, the rest is retired
+    
+    NumaNode() : id(0), first_page(0), num_pages(0), active_pages(0) {}
+};
+
+// Server configuration
+struct CacheConfig {
+    bool numa_aware;       // Split pages into per-node arenas and place them by first touch
+    int fake_numa_nodes;   // > 0: pretend the host has this many nodes (testing)
+    
+    // Threading and CPU affinity (-1 / empty = leave unpinned)
+    int num_worker_threads;
+    int acceptor_core;     // Applied by pinAcceptorThread
+    int io_core;           // Applied by pinIoThread
+    std::vector<int> worker_cores;  // Worker i runs on worker_cores[i % size]
+    
+    // Event loop busy polling: spin on epoll instead of sleeping in the kernel
+    bool busy_poll;
+    int busy_poll_usec;    // SO_BUSY_POLL budget for client sockets (0 = off)
+    
+    // Per-entry CRC32C, verified on GET and after every relocation
+    bool verify_checksums;
+    
+    // Background scrubber rate (0 = disabled)
+    size_t scrub_pages_per_sec;
+    
+    // Shadow every allocation through the reference allocator and report divergence
+    bool differential_check;
+    
+    // Resize the page arena under cgroup/system memory pressure (PSI)
+    bool adapt_to_memory_pressure;
+    std::string psi_path;          // Empty = cgroup memory.pressure, then /proc/pressure/memory
+    double psi_shrink_above;       // "some avg10" percentage that triggers a shrink step
+    double psi_grow_below;         // ...and the level under which the arena grows back
+    double resize_step;            // Fraction of TOTAL_PAGES added/removed per step
+    size_t min_cache_pages;
+    
+    // Return idle free runs to the OS so RSS tracks actual usage
+    bool release_free_pages;
+    size_t release_threshold_pages;  // Only runs at least this long are released
+    int release_grace_ms;            // ...after staying free this long
+    bool release_lazily;             // MADV_FREE instead of MADV_DONTNEED
+    
+    // Compaction groups recently used entries at the front of each arena
+    bool hot_cold_compaction;
+    double hot_fraction;             // Most recently used share of entries treated as hot
+    
+    // Place entries predicted to be short-lived at the top of the arena,
+    // long-lived ones at the bottom, so frees coalesce into large runs
+    bool lifetime_placement;
+    uint64_t short_lifetime;         // Mean lifetime (in allocations) below this is short-lived
+    
+    // A missed key has one filler at a time; its lease lapses after this
+    uint64_t lease_timeout_ms;
+    
+    // Heavy-hitter tracking; one in every hot_key_sample_rate hits is counted
+    bool track_hot_keys;
+    uint32_t hot_key_sample_rate;
+    
+    // Serve the hottest keys from per-thread read copies without taking
+    // cache_mutex; needs track_hot_keys
+    bool replicate_hot_keys;
+    size_t replica_keys;             // At most this many keys are replicated
+    uint64_t replica_min_hits;       // Tracked hits needed before a key is replicated
+    
+    // Miss ratio curve estimation from a spatially sampled share of keys
+    bool estimate_mrc;
+    double mrc_sample_rate;
+    
+    // Background evictor: when free pages drop below the low watermark,
+    // evict down to the high one, and keep a block of at least
+    // min_largest_free_block pages so SETs rarely evict inline. All three
+    // are sized for the full cache and shrink with it in resizeCache.
+    bool proactive_eviction;
+    size_t free_low_watermark;
+    size_t free_high_watermark;
+    size_t min_largest_free_block;
+    uint64_t evictor_interval_ms;
+    
+    CacheConfig() : numa_aware(false), fake_numa_nodes(0),
+                    num_worker_threads(NUM_WORKER_THREADS), acceptor_core(-1), io_core(-1),
+                    busy_poll(false), busy_poll_usec(0), verify_checksums(false),
+                    scrub_pages_per_sec(0), differential_check(false),
+                    adapt_to_memory_pressure(false), psi_shrink_above(10.0), psi_grow_below(1.0),
+                    resize_step(0.1), min_cache_pages(TOTAL_PAGES / 10),
+                    release_free_pages(false), release_threshold_pages(64), release_grace_ms(10000),
+                    release_lazily(false), hot_cold_compaction(false), hot_fraction(0.2),
+                    lifetime_placement(false), short_lifetime(1024),
+                    lease_timeout_ms(2000), track_hot_keys(false), hot_key_sample_rate(1),
+                    replicate_hot_keys(false), replica_keys(16), replica_min_hits(100),
+                    estimate_mrc(false), mrc_sample_rate(0.01),
+                    proactive_eviction(false), free_low_watermark(TOTAL_PAGES / 20),
+                    free_high_watermark(TOTAL_PAGES / 10), min_largest_free_block(256),
+                    evictor_interval_ms(100) {}
+};
+
+// Right to fill a missed key, held by the first client that missed it
+struct FillLease {
+    uint64_t token;
+    uint64_t expires_ms;
+    bool on_miss;  // false for a stale-hit refresh
+    
+    FillLease() : token(0), expires_ms(0), on_miss(true) {}
+    FillLease(uint64_t lease_token, uint64_t expiry, bool missed) 
+        : token(lease_token), expires_ms(expiry), on_miss(missed) {}
+};
+
+// Observed lifetimes of one key prefix, measured in allocations made
+// while an entry was live
+struct LifetimeStats {
+    double mean_lifetime;  // Exponentially weighted mean
+    uint64_t samples;
+    uint64_t last_sample;  // Allocation counter at the latest sample
+    
+    LifetimeStats() : mean_lifetime(0.0), samples(0), last_sample(0) {}
 };
 
 // Cache entry metadata
 struct CacheEntry {
     std::string key;
     std::string client_id;
+    uint64_t key_hash;
     size_t start_page;
     size_t num_pages;
     size_t data_size;
+    uint32_t checksum;  // CRC32C of the value (when checksums are enabled)
+    uint64_t last_access;  // Access clock at the last read or write
+    bool short_lived;      // Placed at the top of its arena by the lifetime predictor
+    uint64_t version;      // CAS stamp, changed on every write
+    uint64_t soft_deadline_ms;  // Served as stale after this (0 = never)
+    uint64_t hard_deadline_ms;  // Removed after this (0 = never)
+    uint64_t soft_ttl_ms;       // Deadlines re-armed from these on every fill
+    uint64_t hard_ttl_ms;
+    double cost;           // Client hint: relative cost of recomputing the value
     
     // Policy-specific data
     std::list<std::string>::iterator lru_iter;
@@ -63,10 +231,14 @@ struct CacheEntry {
     bool visited;
     bool reference_bit;
     size_t clock_position;
+    std::multimap<double, std::string>::iterator gds_iter;
+    bool gds_queued;
+    uint64_t frequency;    // Hits since insertion (GDSF)
     
-    CacheEntry() : start_page(0), num_pages(0), data_size(0), 
-                   insertion_order(0), visited(false), 
-                   reference_bit(false), clock_position(0) {}
+    CacheEntry() : key_hash(0), start_page(0), num_pages(0), data_size(0), 
+                   checksum(0), last_access(0), short_lived(false), version(0), 
+                   soft_deadline_ms(0), hard_deadline_ms(0), soft_ttl_ms(0), hard_ttl_ms(0), cost(1.0), insertion_order(0), visited(false), 
+                   reference_bit(false), clock_position(0), gds_queued(false), frequency(0) {}
 };
 
 // Client connection state
@@ -75,10 +247,11 @@ struct ClientConnection {
     std::string client_id;
     std::string buffer;
     bool authenticated;
+    int home_node;  // NUMA node whose workers should serve this connection
     
-    ClientConnection() : fd(-1), authenticated(false) {}
+    ClientConnection() : fd(-1), authenticated(false), home_node(0) {}
     ClientConnection(int socket_fd) 
-        : fd(socket_fd), authenticated(false) {}
+        : fd(socket_fd), authenticated(false), home_node(0) {}
 };
 
 // Protocol command
@@ -86,9 +259,18 @@ struct Command {
     std::string method;
     std::string key;
     std::string value;
+    double cost;  // Optional recompute cost hint on SETs
     bool valid;
     
-    Command() : valid(false) {}
+    Command() : cost(1.0), valid(false) {}
+};
+
+// Result of one lookup in a pipelined GET batch
+struct BatchGetResult {
+    bool found;
+    std::string value;
+    
+    BatchGetResult() : found(false) {}
 };
 
 // Work item for thread pool
@@ -108,12 +290,38 @@ struct CacheStats {
     std::atomic<uint64_t> deletes{0};
     std::atomic<uint64_t> defragmentations{0};
     std::atomic<uint64_t> coalesces{0};
+    std::atomic<uint64_t> numa_local_allocs{0};
+    std::atomic<uint64_t> numa_remote_allocs{0};
+    std::atomic<uint64_t> checksum_failures{0};
+    std::atomic<uint64_t> scrub_passes{0};
+    std::atomic<uint64_t> scrub_errors{0};
+    std::atomic<uint64_t> resizes{0};
+    std::atomic<uint64_t> pages_released{0};
+    std::atomic<uint64_t> pages_refaulted{0};
+    std::atomic<uint64_t> short_lived_allocs{0};
+    std::atomic<uint64_t> inplace_updates{0};
+    std::atomic<uint64_t> leases_granted{0};
+    std::atomic<uint64_t> lease_waits{0};
+    std::atomic<uint64_t> lease_rejects{0};
+    std::atomic<uint64_t> stale_hits{0};
+    std::atomic<uint64_t> expired_reaped{0};
+    std::atomic<uint64_t> replica_hits{0};
+    std::atomic<uint64_t> bytes_hit{0};     // Value bytes served from the cache
+    std::atomic<uint64_t> bytes_filled{0};  // Value bytes filled after a miss
+    std::atomic<uint64_t> background_evictions{0};
     
     double getHitRatio() const {
         uint64_t total = total_requests.load();
         return total > 0 ? (double)hits.load() / total : 0.0;
     }
     
+    // Filled bytes stand in for missed bytes
+    double getByteHitRatio() const {
+        uint64_t hit = bytes_hit.load();
+        uint64_t total = hit + bytes_filled.load();
+        return total > 0 ? (double)hit / total : 0.0;
+    }
+    
     void reset() {
         total_requests = 0;
         hits = 0;
@@ -124,6 +332,25 @@ struct CacheStats {
         deletes = 0;
         defragmentations = 0;
         coalesces = 0;
+        numa_local_allocs = 0;
+        numa_remote_allocs = 0;
+        checksum_failures = 0;
+        scrub_passes = 0;
+        scrub_errors = 0;
+        resizes = 0;
+        pages_released = 0;
+        pages_refaulted = 0;
+        short_lived_allocs = 0;
+        inplace_updates = 0;
+        leases_granted = 0;
+        lease_waits = 0;
+        lease_rejects = 0;
+        stale_hits = 0;
+        expired_reaped = 0;
+        replica_hits = 0;
+        bytes_hit = 0;
+        bytes_filled = 0;
+        background_evictions = 0;
     }
 };
 
@@ -138,19 +365,114 @@ struct FragmentationStats {
                           num_free_blocks(0), fragmentation_ratio(0.0) {}
 };
 
+// Reference allocator: a native port of CacheWithDefrag (defrag_demo.py),
+// run side by side with the free list allocator in differential mode
+class ReferenceAllocator {
+private:
+    size_t total_pages;
+    size_t total_free;
+    std::map<size_t, size_t> free_blocks;  // start_page -> num_pages
+    std::unordered_map<std::string, std::pair<size_t, size_t>> allocations;
+    
+    void addFreeBlock(size_t start_page, size_t num_pages);
+    
+public:
+    uint64_t defragmentations;
+    uint64_t operations;
+    uint64_t nanos;
+    
+    explicit ReferenceAllocator(size_t pages);
+    
+    bool allocate(const std::string& key, size_t num_pages);
+    bool deallocate(const std::string& key);
+    void defragment();
+    bool contains(const std::string& key) const { return allocations.count(key) > 0; }
+    size_t totalFree() const { return total_free; }
+    FragmentationStats getFragmentationStats() const;
+};
+
+// Heavy-hitter candidate reported by the tracker. The true access count
+// lies in [count - error, count].
+struct HotKey {
+    std::string key;
+    uint64_t count;
+    uint64_t error;
+    
+    HotKey() : count(0), error(0) {}
+    HotKey(const std::string& k, uint64_t c, uint64_t e) : key(k), count(c), error(e) {}
+};
+
+// Space-Saving top-k tracker: a fixed set of counters kept in a min-heap
+// by count, so each access costs one hash lookup and O(log k) sifting
+class HeavyHitters {
+private:
+    size_t capacity;
+    std::vector<HotKey> heap;
+    std::unordered_map<std::string, size_t, KeyHash> positions;  // key -> heap index
+    
+    void siftDown(size_t pos);
+    
+public:
+    explicit HeavyHitters(size_t counters);
+    
+    void offer(const std::string& key, uint64_t count = 1);
+    std::vector<HotKey> top(size_t n) const;
+    void clear();
+};
+
+// SHARDS miss ratio curve estimator. Keys are sampled by hash, so every
+// reference to a sampled key is seen; reuse distances are measured in
+// pages with a Fenwick tree over reference slots and scaled by 1 / rate.
+class MissRatioCurve {
+private:
+    double rate;
+    uint64_t threshold;                  // Sampled when (hash & 0xFFFFFF) < threshold
+    size_t bucket_pages;                 // Histogram resolution
+    std::vector<uint64_t> tree;          // Fenwick tree: pages of the latest reference per slot
+    std::vector<size_t> slot_pages;
+    std::unordered_map<uint64_t, size_t> last_slot;  // key hash -> slot of its latest reference
+    size_t next_slot;
+    std::vector<uint64_t> histogram;     // Reuse distances; the last bucket collects the rest
+    uint64_t cold_refs;
+    uint64_t total_refs;                 // Sampled references
+    uint64_t all_refs;                   // References offered, sampled or not
+    
+    void reference(uint64_t key_hash, size_t pages);
+    void add(size_t slot, int64_t delta);
+    uint64_t prefix(size_t slot) const;
+    void compact();
+    
+public:
+    MissRatioCurve(double sample_rate, size_t max_pages);
+    
+    void offer(uint64_t key_hash, size_t pages) {
+        all_refs++;
+        if ((key_hash & 0xFFFFFF) < threshold) {
+            reference(key_hash, pages);
+        }
+    }
+    double missRatio(size_t cache_pages) const;
+    uint64_t samples() const { return total_refs; }
+    void clear();
+};
+
 // Enhanced Cache Server with Defragmentation
 class CacheServerDefrag {
 private:
     int server_fd;
     int epoll_fd;
-    std::vector<Page> cache;
-    std::unordered_map<std::string, CacheEntry> entries;
+    CacheConfig config;
+    Page* cache;  // TOTAL_PAGES pages, constructed by a thread on each arena's node
+    std::unordered_map<std::string, CacheEntry, KeyHash> entries;
     std::unordered_map<int, ClientConnection> clients;
     
     // Free list management (doubly-linked list of free blocks)
     FreeBlock* free_list_head;
     size_t total_free_pages;
     
+    // NUMA topology (one node covering every page when not NUMA-aware)
+    std::vector<NumaNode> numa_nodes;
+    
     // Eviction policy
     EvictionPolicy policy;
     
@@ -169,6 +491,10 @@ private:
     std::vector<std::string> clock_list;
     size_t clock_hand;
     
+    // GreedyDual-Size(-Frequency): priority -> key, and the inflation value L
+    std::multimap<double, std::string> gds_queue;
+    double gds_inflation;
+    
     // Thread pool
     std::vector<std::thread> worker_threads;
     std::queue<WorkItem> work_queue;
@@ -179,9 +505,64 @@ private:
     // Cache mutex for thread safety
     std::mutex cache_mutex;
     
+    // Background scrubber
+    std::thread scrubber_thread;
+    std::atomic<bool> scrubber_running{false};
+    std::mutex scrub_mutex;
+    std::condition_variable scrub_cv;
+    
+    // Memory pressure monitor
+    std::thread monitor_thread;
+    std::atomic<bool> monitor_running{false};
+    std::mutex monitor_mutex;
+    std::condition_variable monitor_cv;
+    
+    // Background evictor
+    std::thread evictor_thread;
+    std::atomic<bool> evictor_running{false};
+    std::atomic<bool> evictor_wakeup{false};
+    std::mutex evictor_mutex;
+    std::condition_variable evictor_cv;
+    
+    // Logical clock advanced on every access
+    uint64_t access_clock;
+    
+    // Source of CAS version stamps; never reused, even across DELETE/ADD
+    uint64_t version_clock;
+    
+    // Fill leases for missed keys
+    std::unordered_map<std::string, FillLease, KeyHash> leases;
+    uint64_t lease_counter;
+    
+    // Hard deadlines in expiry order; stale records are skipped when reaped
+    std::multimap<uint64_t, std::string> expiry_index;
+    
+    // Most frequently read keys
+    HeavyHitters hot_keys;
+    
+    // Predicted miss ratio at other cache sizes
+    MissRatioCurve mrc;
+    
+    // Keys with per-thread read copies. Bumping replica_generation (under
+    // cache_mutex) discards every thread's copies.
+    std::unordered_set<std::string> replicated_keys;
+    std::atomic<uint64_t> replica_generation{1};
+    
+    // Replica hits flushed by worker threads, credited to hot_keys on refresh
+    std::unordered_map<std::string, uint64_t, KeyHash> replica_hit_counts;
+    
+    // Lifetime predictor, keyed by key prefix
+    std::unordered_map<std::string, LifetimeStats> lifetimes;
+    
     // Statistics
     CacheStats stats;
     
+    // Differential checking against the reference allocator
+    std::unique_ptr<ReferenceAllocator> reference_allocator;
+    uint64_t allocator_operations;
+    uint64_t allocator_nanos;
+    uint64_t differential_mismatches;
+    
     // Private methods
     bool initializeCache();
     bool setupServer(int port);
@@ -190,6 +571,29 @@ private:
     void stopWorkerThreads();
     void workerThreadFunction();
     
+    // NUMA placement
+    void detectNumaTopology();
+    void placeArenas();
+    size_t arenaOf(size_t page) const;
+    size_t largestArenaFree() const;
+    bool isArenaBoundary(size_t page) const;
+    size_t activePages() const;
+    size_t scaleToActive(size_t pages) const;
+    
+    // Adaptive sizing
+    void retireArenaTail(size_t node, size_t target_pages);
+    void releasePageMemory(size_t start_page, size_t num_pages, bool lazy = false);
+    void releaseIdleFreeBlocks();
+    bool readMemoryPressure(double& some_avg10);
+    void monitorThreadFunction();
+    
+    // CPU affinity and event loop
+    void pinWorkerThread(size_t worker_index);
+    void pinAcceptorThread();
+    void pinIoThread();
+    void applySocketBusyPoll(int socket_fd);
+    int waitForEvents(struct epoll_event* events);
+    
     void handleNewConnection();
     void handleClientData(int client_fd);
     void handleClientDisconnect(int client_fd);
@@ -202,21 +606,68 @@ private:
     std::string updateKey(const std::string& key, const std::string& value, const std::string& client_id);
     std::string getKey(const std::string& key, const std::string& client_id);
     std::string deleteKey(const std::string& key, const std::string& client_id);
+    bool tryUpdateInPlace(const std::string& key, const std::string& value);
+    std::string appendKey(const std::string& key, const std::string& value, const std::string& client_id);
+    std::string getRange(const std::string& key, size_t offset, size_t length, const std::string& client_id);
+    std::string incrKey(const std::string& key, int64_t delta, const std::string& client_id);
+    std::string getsKey(const std::string& key, const std::string& client_id);
+    std::string casKey(const std::string& key, const std::string& value, uint64_t expected_version,
+                       const std::string& client_id);
+    bool storeValue(const std::string& key, const std::string& value);
+    std::string leaseGetKey(const std::string& key, const std::string& client_id);
+    std::string leaseSetKey(const std::string& key, const std::string& value, uint64_t token,
+                            const std::string& client_id, double cost = 1.0);
+    void invalidateLease(const std::string& key);
+    std::string expireKey(const std::string& key, uint64_t soft_ttl_ms, uint64_t hard_ttl_ms,
+                          const std::string& client_id);
+    size_t reapExpired();
+    void armDeadlines(CacheEntry& entry);
+    CacheEntry* findLiveEntry(const std::string& key, uint64_t now);
+    void removeEntry(const std::string& key);
+    void removeFromPolicy(CacheEntry& entry);
+    std::string hotKeysReport(size_t n, const std::string& client_id);
+    std::string missRatioReport(const std::string& client_id);
+    std::string getKeyReplicated(const std::string& key, const std::string& client_id);
+    void refreshReplicas();
+    void flushReplicaHits();
+    void invalidateReplica(const std::string& key);
+    void markWritten(CacheEntry& entry);
+    std::vector<BatchGetResult> getKeysBatch(const std::vector<std::string>& keys, const std::string& client_id);
     
     // Memory management with free list
+    bool reservePages(size_t required_pages, bool short_lived, size_t& start_page);
     bool allocatePages(const std::string& key, size_t data_size, const std::string& client_id);
+    bool resizeInPlace(CacheEntry& entry, size_t new_data_size);
+    bool relocateEntry(const std::string& key, size_t new_data_size);
     void freePages(const std::string& key);
     FreeBlock* findBestFitBlock(size_t num_pages);
     FreeBlock* findFirstFitBlock(size_t num_pages);
+    FreeBlock* findBestFitBlockInArena(size_t num_pages, const NumaNode& node);
+    FreeBlock* findFirstFitBlockInRange(size_t num_pages, size_t first_page, size_t end_page);
+    FreeBlock* findLastFitBlock(size_t num_pages, size_t first_page, size_t end_page);
+    FreeBlock* findBlockForCurrentThread(size_t num_pages, bool from_top = false);
     void splitBlock(FreeBlock* block, size_t num_pages);
+    void splitBlockTail(FreeBlock* block, size_t num_pages);
     void addToFreeList(size_t start_page, size_t num_pages);
+    void addRunsToFreeList(std::vector<std::pair<size_t, size_t>>& runs);
     void removeFromFreeList(FreeBlock* block);
     void coalesceAdjacentBlocks(FreeBlock* block);
+    void markPagesUsed(size_t start_page, size_t num_pages);
     size_t calculateRequiredPages(size_t data_size);
     
+    // Lifetime prediction
+    std::string lifetimeClass(const std::string& key) const;
+    bool predictShortLived(const std::string& key);
+    void recordLifetime(const CacheEntry& entry);
+    bool checkAllocatorInvariants();
+    bool shadowAllocation(const std::string& key, size_t num_pages, bool allocated,
+                          std::chrono::steady_clock::time_point started);
+    void shadowDeallocation(const std::string& key);
+    
     // Defragmentation
     bool defragment(size_t required_pages);
-    void compactMemory();
+    void compactMemory(bool pack_to_front = false);
+    void orderHotCold(std::vector<std::pair<std::string, CacheEntry>>& arena_entries);
     FragmentationStats getFragmentationStats();
     
     // Eviction policies
@@ -225,6 +676,10 @@ private:
     bool evictFIFO(size_t required_pages);
     bool evictSIEVE(size_t required_pages);
     bool evictClock(size_t required_pages);
+    bool evictGDS(size_t required_pages);
+    bool evictBatch(size_t required_pages, bool contiguous = true);
+    void evictorThreadFunction();
+    bool selectVictim(std::string& key);
     
     // Policy-specific updates
     void updatePolicy(const std::string& key);
@@ -232,10 +687,29 @@ private:
     void updateFIFO(const std::string& key);
     void updateSIEVE(const std::string& key);
     void updateClock(const std::string& key);
+    void updateGDS(const std::string& key);
+    void reprioritizeGDS(CacheEntry& entry);
+    void applyCostHint(const std::string& key, double cost);
+    void recordAccess(CacheEntry& entry);
     
     // Data operations
     bool writeToPages(size_t start_page, const std::string& data);
     std::string readFromPages(size_t start_page, size_t data_size);
+    void writePageRun(size_t start_page, const uint8_t* src, size_t len);
+    void readPageRun(size_t start_page, uint8_t* dst, size_t len);
+    void movePageRun(size_t from_page, size_t to_page, size_t len);
+    void writePageRange(size_t start_page, size_t offset, const uint8_t* src, size_t len);
+    void readPageRange(size_t start_page, size_t offset, uint8_t* dst, size_t len);
+    
+    // Value checksums
+    uint32_t checksumPages(size_t start_page, size_t data_size);
+    void sealEntry(CacheEntry& entry);
+    bool verifyEntry(const CacheEntry& entry);
+    
+    // Background scrubbing
+    void scrubberThreadFunction();
+    size_t scrubPages(const CacheEntry& entry, size_t first, size_t count, uint32_t& crc);
+    size_t verifyFreeList();
     
     // Utility
     void sendResponse(int client_fd, const std::string& response);
@@ -243,13 +717,34 @@ private:
     void printFreeList();
 
 public:
-    CacheServerDefrag(EvictionPolicy eviction_policy = EvictionPolicy::LRU);
+    CacheServerDefrag(EvictionPolicy eviction_policy = EvictionPolicy::LRU,
+                      const CacheConfig& cache_config = CacheConfig());
     ~CacheServerDefrag();
     
     bool start(int port);
     void run();
     void stop();
     
+    // NUMA placement for worker threads and connections
+    size_t numNumaNodes() const { return numa_nodes.size(); }
+    bool pinThreadToNode(int node);
+    int nodeForConnection(int client_fd);
+    bool pinThreadToCore(int core);
+    int numWorkerThreads() const { return config.num_worker_threads; }
+    
+    // Background integrity scrubber
+    void startScrubber();
+    void stopScrubber();
+    
+    // Grow or shrink the page arena at runtime; returns the size achieved
+    size_t resizeCache(size_t target_pages);
+    void startMemoryMonitor();
+    void stopMemoryMonitor();
+    
+    // Keep free space above the configured watermarks in the background
+    void startEvictor();
+    void stopEvictor();
+    
     // Statistics
     const CacheStats& getStats() const { return stats; }
     void resetStats() { stats.reset(); }
@@ -3,12 +3,28 @@
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include <functional>
+#include <new>
+#include <stdexcept>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
 #include <iomanip>
+#include <chrono>
+#include <cassert>
+#include <sys/mman.h>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 const char* policyName(EvictionPolicy policy) {
     switch(policy) {
@@ -16,19 +32,307 @@ const char* policyName(EvictionPolicy policy) {
         case EvictionPolicy::FIFO: return "FIFO";
         case EvictionPolicy::SIEVE: return "SIEVE";
         case EvictionPolicy::CLOCK: return "CLOCK";
+        case EvictionPolicy::GDS: return "GDS";
+        case EvictionPolicy::GDSF: return "GDSF";
         default: return "UNKNOWN";
     }
 }
 
-CacheServerDefrag::CacheServerDefrag(EvictionPolicy eviction_policy) 
-    : server_fd(-1), epoll_fd(-1), free_list_head(nullptr), 
+// Key Hashing
+
+static const uint64_t HASH_SECRET[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+static inline uint64_t hashRead64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hashRead32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 64x64 -> 128 bit multiply folded back to 64 bits
+static inline uint64_t hashMix(uint64_t a, uint64_t b) {
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+// Accumulate 32-byte stripes into 4 lanes. Both paths compute identical
+// results: acc[i] += lo32(d ^ s) * hi32(d ^ s) + d[i ^ 1]
+static void hashStripesScalar(uint64_t acc[4], const uint8_t* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; ++s, p += 32) {
+        uint64_t data[4];
+        for (int i = 0; i < 4; ++i) {
+            data[i] = hashRead64(p + i * 8);
+        }
+        for (int i = 0; i < 4; ++i) {
+            uint64_t keyed = data[i] ^ HASH_SECRET[i];
+            acc[i] += (keyed & 0xffffffffULL) * (keyed >> 32) + data[i ^ 1];
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void hashStripesAvx2(uint64_t acc[4], const uint8_t* p, size_t stripes) {
+    __m256i vacc = _mm256_loadu_si256((const __m256i*)acc);
+    const __m256i secret = _mm256_loadu_si256((const __m256i*)HASH_SECRET);
+    for (size_t s = 0; s < stripes; ++s, p += 32) {
+        __m256i data = _mm256_loadu_si256((const __m256i*)p);
+        __m256i keyed = _mm256_xor_si256(data, secret);
+        __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+        __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        vacc = _mm256_add_epi64(vacc, _mm256_add_epi64(product, swapped));
+    }
+    _mm256_storeu_si256((__m256i*)acc, vacc);
+}
+#endif
+
+typedef void (*HashStripesFn)(uint64_t acc[4], const uint8_t* p, size_t stripes);
+
+static HashStripesFn selectHashStripes() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        return hashStripesAvx2;
+    }
+#endif
+    return hashStripesScalar;
+}
+
+static const HashStripesFn hash_stripes = selectHashStripes();
+
+uint64_t hashKey(const char* key, size_t len) {
+    const uint8_t* p = (const uint8_t*)key;
+    uint64_t seed = HASH_SECRET[0] ^ hashMix(len, HASH_SECRET[1]);
+    uint64_t a, b;
+    
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (hashRead32(p) << 32) | hashRead32(p + mid);
+            b = (hashRead32(p + len - 4) << 32) | hashRead32(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t remaining = len;
+        
+        // Long keys: vectorizable stripe loop
+        if (len >= 64) {
+            uint64_t acc[4];
+            for (int i = 0; i < 4; ++i) {
+                acc[i] = HASH_SECRET[i] ^ seed;
+            }
+            size_t stripes = len / 32;
+            hash_stripes(acc, p, stripes);
+            seed = hashMix(acc[0] ^ acc[2], acc[1] ^ acc[3]) ^ seed;
+            p += stripes * 32;
+            remaining -= stripes * 32;
+        }
+        
+        while (remaining > 16) {
+            seed = hashMix(hashRead64(p) ^ HASH_SECRET[1], hashRead64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        
+        // Last 16 bytes of the key (may overlap bytes already mixed)
+        const uint8_t* tail = (const uint8_t*)key + len - 16;
+        a = hashRead64(tail);
+        b = hashRead64(tail + 8);
+    }
+    
+    return hashMix(HASH_SECRET[1] ^ len, hashMix(a ^ HASH_SECRET[1], b ^ seed));
+}
+
+// Bulk Copy Kernels
+
+static void streamCopyPortable(uint8_t* dst, const uint8_t* src, size_t len) {
+    std::memcpy(dst, src, len);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Non-temporal copies: large values go straight to memory instead of
+// evicting the hot index from the CPU caches
+__attribute__((target("sse2")))
+static void streamCopySse2(uint8_t* dst, const uint8_t* src, size_t len) {
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    head = std::min(head, len);
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+    
+    for (; len >= 64; len -= 64, dst += 64, src += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_stream_si128((__m128i*)dst, a);
+        _mm_stream_si128((__m128i*)(dst + 16), b);
+        _mm_stream_si128((__m128i*)(dst + 32), c);
+        _mm_stream_si128((__m128i*)(dst + 48), d);
+    }
+    _mm_sfence();
+    std::memcpy(dst, src, len);
+}
+
+__attribute__((target("avx2")))
+static void streamCopyAvx2(uint8_t* dst, const uint8_t* src, size_t len) {
+    size_t head = (32 - ((uintptr_t)dst & 31)) & 31;
+    head = std::min(head, len);
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+    
+    for (; len >= 128; len -= 128, dst += 128, src += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)src);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(src + 96));
+        _mm256_stream_si256((__m256i*)dst, a);
+        _mm256_stream_si256((__m256i*)(dst + 32), b);
+        _mm256_stream_si256((__m256i*)(dst + 64), c);
+        _mm256_stream_si256((__m256i*)(dst + 96), d);
+    }
+    _mm_sfence();
+    std::memcpy(dst, src, len);
+}
+#endif
+
+typedef void (*StreamCopyFn)(uint8_t* dst, const uint8_t* src, size_t len);
+
+static StreamCopyFn selectStreamCopy() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        return streamCopyAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return streamCopySse2;
+    }
+#endif
+    return streamCopyPortable;
+}
+
+static const StreamCopyFn stream_copy = selectStreamCopy();
+
+// CRC32C
+
+static uint32_t crc32c_table[256];
+
+static bool initCrc32cTable() {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0x82f63b78U & (0U - (crc & 1)));
+        }
+        crc32c_table[i] = crc;
+    }
+    return true;
+}
+
+static uint32_t crc32cPortable(uint32_t crc, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        crc = crc32c_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42(uint32_t crc, const uint8_t* data, size_t len) {
+    uint64_t crc64 = crc;
+    for (; len >= 8; len -= 8, data += 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    uint32_t crc32 = (uint32_t)crc64;
+    for (; len > 0; --len, ++data) {
+        crc32 = _mm_crc32_u8(crc32, *data);
+    }
+    return crc32;
+}
+#endif
+
+typedef uint32_t (*Crc32cFn)(uint32_t crc, const uint8_t* data, size_t len);
+
+static Crc32cFn selectCrc32c() {
+    initCrc32cTable();
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32cSse42;
+    }
+#endif
+    return crc32cPortable;
+}
+
+static const Crc32cFn crc32c_impl = selectCrc32c();
+
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t len) {
+    return ~crc32c_impl(~crc, data, len);
+}
+
+static uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// NUMA node of the calling thread (-1 = not pinned)
+static thread_local int current_numa_node = -1;
+
+// Read copies of hot keys held by the calling worker thread
+struct ReplicaCache {
+    const void* owner;       // Server the copies belong to
+    uint64_t generation;     // replica_generation the copies were taken at
+    std::unordered_map<std::string, std::string> values;
+    std::unordered_map<std::string, uint64_t> hits;  // Replica hits not yet flushed
+    uint64_t pending_hits;
+    
+    ReplicaCache() : owner(nullptr), generation(0), pending_hits(0) {}
+};
+static thread_local ReplicaCache replica_cache;
+
+// Parse a sysfs cpulist such as "0-3,8-11"
+static std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int first = std::atoi(range.substr(0, dash).c_str());
+        int last = (dash == std::string::npos) ? first : std::atoi(range.substr(dash + 1).c_str());
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+CacheServerDefrag::CacheServerDefrag(EvictionPolicy eviction_policy, const CacheConfig& cache_config) 
+    : server_fd(-1), epoll_fd(-1), config(cache_config), cache(nullptr), free_list_head(nullptr), 
       total_free_pages(TOTAL_PAGES), policy(eviction_policy), 
-      fifo_counter(0), clock_hand(0) {
-    cache.reserve(TOTAL_PAGES);
+      fifo_counter(0), clock_hand(0), gds_inflation(0.0), access_clock(0), version_clock(0), lease_counter(0),
+      hot_keys(HOT_KEY_CAPACITY), mrc(cache_config.mrc_sample_rate, TOTAL_PAGES * 8), allocator_operations(0), allocator_nanos(0),
+      differential_mismatches(0) {
     sieve_hand = sieve_list.end();
 }
 
 CacheServerDefrag::~CacheServerDefrag() {
+    stopEvictor();
+    stopMemoryMonitor();
+    stopScrubber();
     stop();
     
     // Clean up free list
@@ -38,6 +342,10 @@ CacheServerDefrag::~CacheServerDefrag() {
         delete current;
         current = next;
     }
+    
+    if (cache) {
+        munmap(cache, TOTAL_PAGES * sizeof(Page));
+    }
 }
 
 bool CacheServerDefrag::initializeCache() {
@@ -46,15 +354,73 @@ bool CacheServerDefrag::initializeCache() {
         std::cout << "  Policy: " << policyName(policy) << std::endl;
         std::cout << "  Pages: " << TOTAL_PAGES << " x " << PAGE_SIZE << " bytes" << std::endl;
         
-        cache.resize(TOTAL_PAGES);
+        if (config.proactive_eviction && config.free_low_watermark > config.free_high_watermark) {
+            throw std::invalid_argument("free_low_watermark is above free_high_watermark");
+        }
+        
+        // Reserve the pages without touching them: Page() writes into every
+        // page, and that first write decides which node backs it
+        void* storage = mmap(nullptr, TOTAL_PAGES * sizeof(Page), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (storage == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        cache = static_cast<Page*>(storage);
+        detectNumaTopology();
         
-        // Initialize free list with entire cache as one block
-        free_list_head = new FreeBlock(0, TOTAL_PAGES);
+        // Initialize free list with one block per arena. The pages are
+        // touched below, so the release grace period starts now.
+        FreeBlock* tail = nullptr;
+        uint64_t now = nowMs();
+        for (const NumaNode& node : numa_nodes) {
+            FreeBlock* block = new FreeBlock(node.first_page, node.num_pages);
+            block->freed_at_ms = now;
+            if (tail) {
+                tail->next = block;
+                block->prev = tail;
+            } else {
+                free_list_head = block;
+            }
+            tail = block;
+        }
         total_free_pages = TOTAL_PAGES;
         
+        if (config.numa_aware && numa_nodes.size() > 1) {
+            placeArenas();
+        } else {
+            for (size_t i = 0; i < TOTAL_PAGES; ++i) {
+                new (&cache[i]) Page();
+            }
+        }
+        
+        if (config.differential_check) {
+            if (numa_nodes.size() == 1) {
+                reference_allocator.reset(new ReferenceAllocator(TOTAL_PAGES));
+            } else {
+                std::cerr << "Differential check needs a single arena, disabled" << std::endl;
+            }
+        }
+        
         std::cout << "  Total cache size: " << (CACHE_SIZE / (1024.0 * 1024)) << " MB" << std::endl;
-        std::cout << "  Free list initialized: 1 block of " << TOTAL_PAGES << " pages" << std::endl;
+        std::cout << "  NUMA arenas: " << numa_nodes.size() << std::endl;
+        for (const NumaNode& node : numa_nodes) {
+            std::cout << "    Node " << node.id << ": pages " << node.first_page << "-"
+                      << (node.first_page + node.num_pages - 1) << ", "
+                      << node.cpus.size() << " CPUs" << std::endl;
+        }
+        std::cout << "  Free list initialized: " << numa_nodes.size() << " block(s) of " 
+                  << numa_nodes[0].num_pages << " pages" << std::endl;
         std::cout << "Cache initialized successfully!" << std::endl;
+        
+        if (config.scrub_pages_per_sec > 0) {
+            startScrubber();
+        }
+        if (config.adapt_to_memory_pressure || config.release_free_pages) {
+            startMemoryMonitor();
+        }
+        if (config.proactive_eviction) {
+            startEvictor();
+        }
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Failed to initialize cache: " << e.what() << std::endl;
@@ -62,6 +428,247 @@ bool CacheServerDefrag::initializeCache() {
     }
 }
 
+// NUMA Placement
+
+void CacheServerDefrag::detectNumaTopology() {
+    numa_nodes.clear();
+    
+    if (config.numa_aware && config.fake_numa_nodes > 0) {
+        // Fake topology: spread the online CPUs evenly across the nodes,
+        // sharing them when there are more nodes than CPUs
+        int num_cpus = std::max(1, (int)std::thread::hardware_concurrency());
+        int count = config.fake_numa_nodes;
+        for (int n = 0; n < count; ++n) {
+            NumaNode node;
+            node.id = n;
+            if (num_cpus >= count) {
+                for (int cpu = n * num_cpus / count; cpu < (n + 1) * num_cpus / count; ++cpu) {
+                    node.cpus.push_back(cpu);
+                }
+            } else {
+                node.cpus.push_back(n % num_cpus);
+            }
+            numa_nodes.push_back(node);
+        }
+    } else if (config.numa_aware) {
+        DIR* dir = opendir("/sys/devices/system/node");
+        if (dir) {
+            struct dirent* ent;
+            while ((ent = readdir(dir)) != nullptr) {
+                int id;
+                if (std::sscanf(ent->d_name, "node%d", &id) != 1) continue;
+                
+                std::ifstream file(std::string("/sys/devices/system/node/") + ent->d_name + "/cpulist");
+                std::string list;
+                std::getline(file, list);
+                
+                NumaNode node;
+                node.id = id;
+                node.cpus = parseCpuList(list);
+                
+                // Memory-only nodes have no CPUs to run workers on
+                if (!node.cpus.empty()) {
+                    numa_nodes.push_back(node);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(numa_nodes.begin(), numa_nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    }
+    
+    // Single-node fallback: one arena, threads may run anywhere
+    if (numa_nodes.empty()) {
+        numa_nodes.push_back(NumaNode());
+    }
+    
+    // Split pages evenly, the last arena takes the remainder
+    size_t per_node = TOTAL_PAGES / numa_nodes.size();
+    for (size_t n = 0; n < numa_nodes.size(); ++n) {
+        numa_nodes[n].first_page = n * per_node;
+        numa_nodes[n].num_pages = (n + 1 == numa_nodes.size()) ? TOTAL_PAGES - n * per_node : per_node;
+        numa_nodes[n].active_pages = numa_nodes[n].num_pages;
+    }
+}
+
+void CacheServerDefrag::placeArenas() {
+    // Construct and touch each arena first from a thread running on its
+    // node, so the kernel backs it with node-local memory
+    std::vector<std::thread> touchers;
+    for (size_t n = 0; n < numa_nodes.size(); ++n) {
+        touchers.emplace_back([this, n]() {
+            pinThreadToNode((int)n);
+            const NumaNode& node = numa_nodes[n];
+            for (size_t i = node.first_page; i < node.first_page + node.num_pages; ++i) {
+                new (&cache[i]) Page();
+                std::memset(cache[i].data, 0, PAGE_SIZE);
+            }
+        });
+    }
+    for (auto& toucher : touchers) {
+        toucher.join();
+    }
+}
+
+size_t CacheServerDefrag::arenaOf(size_t page) const {
+    for (size_t n = 1; n < numa_nodes.size(); ++n) {
+        if (page < numa_nodes[n].first_page) {
+            return n - 1;
+        }
+    }
+    return numa_nodes.size() - 1;
+}
+
+size_t CacheServerDefrag::largestArenaFree() const {
+    // Most free pages in any one arena: the largest block compaction can
+    // build, since blocks never span arenas
+    std::vector<size_t> free_pages(numa_nodes.size(), 0);
+    for (FreeBlock* block = free_list_head; block; block = block->next) {
+        free_pages[arenaOf(block->start_page)] += block->num_pages;
+    }
+    return *std::max_element(free_pages.begin(), free_pages.end());
+}
+
+size_t CacheServerDefrag::activePages() const {
+    size_t pages = 0;
+    for (const NumaNode& node : numa_nodes) {
+        pages += node.active_pages;
+    }
+    return pages;
+}
+
+size_t CacheServerDefrag::scaleToActive(size_t pages) const {
+    // A full-cache page count, in proportion to the pages currently active
+    return pages * activePages() / TOTAL_PAGES;
+}
+
+bool CacheServerDefrag::isArenaBoundary(size_t page) const {
+    for (size_t n = 1; n < numa_nodes.size(); ++n) {
+        if (numa_nodes[n].first_page == page) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CacheServerDefrag::pinThreadToNode(int node) {
+    if (node < 0 || (size_t)node >= numa_nodes.size()) {
+        return false;
+    }
+    current_numa_node = node;
+    
+    const std::vector<int>& cpus = numa_nodes[node].cpus;
+    if (cpus.empty()) {
+        return true;
+    }
+    
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+int CacheServerDefrag::nodeForConnection(int client_fd) {
+    if (numa_nodes.size() <= 1) {
+        return 0;
+    }
+    
+#ifdef SO_INCOMING_CPU
+    // Steer to the node whose CPU received the connection's packets
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(client_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0 && cpu >= 0) {
+        for (size_t n = 0; n < numa_nodes.size(); ++n) {
+            const std::vector<int>& cpus = numa_nodes[n].cpus;
+            if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+                return (int)n;
+            }
+        }
+    }
+#endif
+    
+    return client_fd % (int)numa_nodes.size();
+}
+
+// CPU Affinity
+
+bool CacheServerDefrag::pinThreadToCore(int core) {
+    if (core < 0) {
+        return false;
+    }
+    
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        std::cerr << "Failed to pin thread to core " << core << std::endl;
+        return false;
+    }
+    
+    // Keep allocations local to the core's node
+    for (size_t n = 0; n < numa_nodes.size(); ++n) {
+        const std::vector<int>& cpus = numa_nodes[n].cpus;
+        if (std::find(cpus.begin(), cpus.end(), core) != cpus.end()) {
+            current_numa_node = (int)n;
+            break;
+        }
+    }
+    return true;
+}
+
+void CacheServerDefrag::pinWorkerThread(size_t worker_index) {
+    // Explicit core list wins, otherwise spread workers over NUMA nodes
+    if (!config.worker_cores.empty()) {
+        pinThreadToCore(config.worker_cores[worker_index % config.worker_cores.size()]);
+    } else if (config.numa_aware && numa_nodes.size() > 1) {
+        pinThreadToNode((int)(worker_index % numa_nodes.size()));
+    }
+}
+
+void CacheServerDefrag::pinAcceptorThread() {
+    // Called on the thread running the accept loop; -1 leaves it unpinned
+    pinThreadToCore(config.acceptor_core);
+}
+
+void CacheServerDefrag::pinIoThread() {
+    // Called on the event loop thread; -1 leaves it unpinned
+    pinThreadToCore(config.io_core);
+}
+
+void CacheServerDefrag::applySocketBusyPoll(int socket_fd) {
+#ifdef SO_BUSY_POLL
+    if (config.busy_poll_usec > 0) {
+        int usec = config.busy_poll_usec;
+        if (setsockopt(socket_fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) < 0) {
+            std::cerr << "Failed to set SO_BUSY_POLL on fd " << socket_fd << std::endl;
+        }
+    }
+#else
+    (void)socket_fd;
+#endif
+}
+
+int CacheServerDefrag::waitForEvents(struct epoll_event* events) {
+    if (!config.busy_poll) {
+        // Wake up periodically to notice should_stop
+        return epoll_wait(epoll_fd, events, MAX_EVENTS, 100);
+    }
+    
+    // Busy poll: never sleep in the kernel, trading a core for tail latency
+    while (!should_stop) {
+        int nfds = epoll_wait(epoll_fd, events, MAX_EVENTS, 0);
+        if (nfds != 0) {
+            return nfds;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    return 0;
+}
+
 // Free List Management Functions
 
 FreeBlock* CacheServerDefrag::findBestFitBlock(size_t num_pages) {
@@ -85,6 +692,89 @@ FreeBlock* CacheServerDefrag::findBestFitBlock(size_t num_pages) {
     return best_fit;
 }
 
+FreeBlock* CacheServerDefrag::findBestFitBlockInArena(size_t num_pages, const NumaNode& node) {
+    FreeBlock* best_fit = nullptr;
+    size_t best_size = SIZE_MAX;
+    size_t arena_end = node.first_page + node.num_pages;
+    
+    // Blocks never straddle arenas, so the start page decides ownership
+    FreeBlock* current = free_list_head;
+    while (current && current->start_page < arena_end) {
+        if (current->start_page >= node.first_page &&
+            current->num_pages >= num_pages && current->num_pages < best_size) {
+            best_fit = current;
+            best_size = current->num_pages;
+            
+            if (current->num_pages == num_pages) {
+                break;
+            }
+        }
+        current = current->next;
+    }
+    
+    return best_fit;
+}
+
+FreeBlock* CacheServerDefrag::findFirstFitBlockInRange(size_t num_pages, size_t first_page, size_t end_page) {
+    // Lowest-addressed block that fits, for allocations packed from the bottom
+    FreeBlock* current = free_list_head;
+    while (current && current->start_page < end_page) {
+        if (current->start_page >= first_page && current->num_pages >= num_pages) {
+            return current;
+        }
+        current = current->next;
+    }
+    return nullptr;
+}
+
+FreeBlock* CacheServerDefrag::findLastFitBlock(size_t num_pages, size_t first_page, size_t end_page) {
+    // Highest-addressed block that fits, for allocations taken from the top
+    FreeBlock* last_fit = nullptr;
+    FreeBlock* current = free_list_head;
+    while (current && current->start_page < end_page) {
+        if (current->start_page >= first_page && current->num_pages >= num_pages) {
+            last_fit = current;
+        }
+        current = current->next;
+    }
+    return last_fit;
+}
+
+FreeBlock* CacheServerDefrag::findBlockForCurrentThread(size_t num_pages, bool from_top) {
+    // Lifetime placement packs long-lived entries from the bottom (first fit)
+    // and short-lived ones from the top (last fit); otherwise best fit
+    auto find_in_range = [&](size_t first_page, size_t end_page) -> FreeBlock* {
+        if (from_top) {
+            return findLastFitBlock(num_pages, first_page, end_page);
+        }
+        if (config.lifetime_placement) {
+            return findFirstFitBlockInRange(num_pages, first_page, end_page);
+        }
+        if (first_page == 0 && end_page == TOTAL_PAGES) {
+            return findBestFitBlock(num_pages);
+        }
+        return findBestFitBlockInArena(num_pages, numa_nodes[arenaOf(first_page)]);
+    };
+    
+    // Prefer the calling worker's local arena, spill to any other node
+    if (numa_nodes.size() > 1 && current_numa_node >= 0) {
+        const NumaNode& node = numa_nodes[current_numa_node];
+        FreeBlock* block = find_in_range(node.first_page, node.first_page + node.num_pages);
+        if (block) {
+            stats.numa_local_allocs++;
+            return block;
+        }
+        
+        block = find_in_range(0, TOTAL_PAGES);
+        if (block) {
+            stats.numa_remote_allocs++;
+        }
+        return block;
+    }
+    
+    return find_in_range(0, TOTAL_PAGES);
+}
+
 FreeBlock* CacheServerDefrag::findFirstFitBlock(size_t num_pages) {
     FreeBlock* current = free_list_head;
     while (current) {
@@ -105,12 +795,25 @@ void CacheServerDefrag::splitBlock(FreeBlock* block, size_t num_pages) {
         // Split block - update size and start
         block->start_page += num_pages;
         block->num_pages -= num_pages;
+        total_free_pages -= num_pages;
+    }
+}
+
+void CacheServerDefrag::splitBlockTail(FreeBlock* block, size_t num_pages) {
+    if (block->num_pages == num_pages) {
+        removeFromFreeList(block);
+        delete block;
+    } else {
+        // Allocate from the end - the block keeps its start
+        block->num_pages -= num_pages;
+        total_free_pages -= num_pages;
     }
 }
 
 void CacheServerDefrag::addToFreeList(size_t start_page, size_t num_pages) {
     // Create new free block
     FreeBlock* new_block = new FreeBlock(start_page, num_pages);
+    new_block->freed_at_ms = nowMs();
     
     // Insert in sorted order by start_page for easier coalescing
     if (!free_list_head || start_page < free_list_head->start_page) {
@@ -142,6 +845,47 @@ void CacheServerDefrag::addToFreeList(size_t start_page, size_t num_pages) {
     coalesceAdjacentBlocks(new_block);
 }
 
+void CacheServerDefrag::addRunsToFreeList(std::vector<std::pair<size_t, size_t>>& runs) {
+    // Insert many (start_page, num_pages) runs in one sorted merge: the
+    // cursor only moves forward, so the free list is walked once
+    std::sort(runs.begin(), runs.end());
+    uint64_t now = nowMs();
+    FreeBlock* cursor = nullptr;  // Last block starting before the current run
+    
+    for (const auto& run : runs) {
+        FreeBlock* new_block = new FreeBlock(run.first, run.second);
+        new_block->freed_at_ms = now;
+        
+        FreeBlock* after = cursor ? cursor : free_list_head;
+        if (!after || run.first < after->start_page) {
+            // Insert at head
+            new_block->next = free_list_head;
+            if (free_list_head) {
+                free_list_head->prev = new_block;
+            }
+            free_list_head = new_block;
+        } else {
+            while (after->next && after->next->start_page < run.first) {
+                after = after->next;
+            }
+            new_block->next = after->next;
+            new_block->prev = after;
+            if (after->next) {
+                after->next->prev = new_block;
+            }
+            after->next = new_block;
+        }
+        total_free_pages += run.second;
+        
+        // Coalescing may fold the new block into its predecessor
+        FreeBlock* prev = new_block->prev;
+        bool into_prev = prev && prev->start_page + prev->num_pages == run.first &&
+                         !isArenaBoundary(run.first);
+        coalesceAdjacentBlocks(new_block);
+        cursor = into_prev ? prev : new_block;
+    }
+}
+
 void CacheServerDefrag::removeFromFreeList(FreeBlock* block) {
     if (block->prev) {
         block->prev->next = block->next;
@@ -159,10 +903,12 @@ void CacheServerDefrag::removeFromFreeList(FreeBlock* block) {
 void CacheServerDefrag::coalesceAdjacentBlocks(FreeBlock* block) {
     stats.coalesces++;
     
-    // Try to merge with next block
-    if (block->next && (block->start_page + block->num_pages == block->next->start_page)) {
+    // Try to merge with next block (never across a NUMA arena boundary)
+    if (block->next && (block->start_page + block->num_pages == block->next->start_page) &&
+        !isArenaBoundary(block->next->start_page)) {
         FreeBlock* next_block = block->next;
         block->num_pages += next_block->num_pages;
+        block->freed_at_ms = std::max(block->freed_at_ms, next_block->freed_at_ms);
         block->next = next_block->next;
         if (next_block->next) {
             next_block->next->prev = block;
@@ -171,9 +917,11 @@ void CacheServerDefrag::coalesceAdjacentBlocks(FreeBlock* block) {
     }
     
     // Try to merge with previous block
-    if (block->prev && (block->prev->start_page + block->prev->num_pages == block->start_page)) {
+    if (block->prev && (block->prev->start_page + block->prev->num_pages == block->start_page) &&
+        !isArenaBoundary(block->start_page)) {
         FreeBlock* prev_block = block->prev;
         prev_block->num_pages += block->num_pages;
+        prev_block->freed_at_ms = std::max(prev_block->freed_at_ms, block->freed_at_ms);
         prev_block->next = block->next;
         if (block->next) {
             block->next->prev = prev_block;
@@ -182,11 +930,562 @@ void CacheServerDefrag::coalesceAdjacentBlocks(FreeBlock* block) {
     }
 }
 
-// Defragmentation Functions
+void CacheServerDefrag::markPagesUsed(size_t start_page, size_t num_pages) {
+    for (size_t i = start_page; i < start_page + num_pages; ++i) {
+        cache[i].is_free = false;
+        cache[i].block_start = start_page;
+        
+        // Released pages fault back in zero-filled on first write
+        if (cache[i].released) {
+            cache[i].released = false;
+            stats.pages_refaulted++;
+        }
+    }
+}
 
-FragmentationStats CacheServerDefrag::getFragmentationStats() {
-    FragmentationStats frag_stats;
-    frag_stats.total_free_pages = total_free_pages;
+bool CacheServerDefrag::checkAllocatorInvariants() {
+    // Free list must be sorted, non-overlapping, fully coalesced (except at
+    // arena boundaries) and agree with the page flags and counters
+    size_t listed_pages = 0;
+    FreeBlock* prev = nullptr;
+    
+    for (FreeBlock* current = free_list_head; current; prev = current, current = current->next) {
+        if (current->prev != prev) {
+            std::cerr << "[INVARIANT] Broken back link at block " << current->start_page << std::endl;
+            return false;
+        }
+        const NumaNode& node = numa_nodes[arenaOf(current->start_page)];
+        if (current->num_pages == 0 || 
+            current->start_page + current->num_pages > node.first_page + node.active_pages) {
+            std::cerr << "[INVARIANT] Block " << current->start_page << " has bad size " 
+                      << current->num_pages << std::endl;
+            return false;
+        }
+        if (prev) {
+            size_t prev_end = prev->start_page + prev->num_pages;
+            if (prev_end > current->start_page) {
+                std::cerr << "[INVARIANT] Blocks at " << prev->start_page << " and " 
+                          << current->start_page << " are unsorted or overlap" << std::endl;
+                return false;
+            }
+            if (prev_end == current->start_page && !isArenaBoundary(current->start_page)) {
+                std::cerr << "[INVARIANT] Blocks at " << prev->start_page << " and " 
+                          << current->start_page << " were not coalesced" << std::endl;
+                return false;
+            }
+        }
+        for (size_t i = current->start_page; i < current->start_page + current->num_pages; ++i) {
+            if (!cache[i].is_free) {
+                std::cerr << "[INVARIANT] Free block at " << current->start_page 
+                          << " covers used page " << i << std::endl;
+                return false;
+            }
+        }
+        listed_pages += current->num_pages;
+    }
+    
+    size_t flagged_pages = 0;
+    for (size_t i = 0; i < TOTAL_PAGES; ++i) {
+        if (cache[i].is_free) {
+            flagged_pages++;
+        }
+    }
+    
+    if (listed_pages != total_free_pages || flagged_pages != total_free_pages) {
+        std::cerr << "[INVARIANT] Free page counts disagree: " << listed_pages << " listed, " 
+                  << flagged_pages << " flagged, " << total_free_pages << " counted" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Reference Allocator (differential testing)
+
+ReferenceAllocator::ReferenceAllocator(size_t pages)
+    : total_pages(pages), total_free(pages), defragmentations(0), operations(0), nanos(0) {
+    free_blocks[0] = pages;
+}
+
+void ReferenceAllocator::addFreeBlock(size_t start_page, size_t num_pages) {
+    auto next = free_blocks.lower_bound(start_page);
+    
+    // Coalesce with the following block
+    if (next != free_blocks.end() && start_page + num_pages == next->first) {
+        num_pages += next->second;
+        next = free_blocks.erase(next);
+    }
+    
+    // Coalesce with the preceding block
+    if (next != free_blocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == start_page) {
+            prev->second += num_pages;
+            return;
+        }
+    }
+    free_blocks[start_page] = num_pages;
+}
+
+bool ReferenceAllocator::allocate(const std::string& key, size_t num_pages) {
+    auto find_best_fit = [&]() {
+        auto best = free_blocks.end();
+        for (auto it = free_blocks.begin(); it != free_blocks.end(); ++it) {
+            if (it->second >= num_pages && (best == free_blocks.end() || it->second < best->second)) {
+                best = it;
+            }
+        }
+        return best;
+    };
+    
+    auto block = find_best_fit();
+    if (block == free_blocks.end() && total_free >= num_pages) {
+        defragment();
+        block = find_best_fit();
+    }
+    if (block == free_blocks.end()) {
+        return false;
+    }
+    
+    size_t start_page = block->first;
+    size_t remaining = block->second - num_pages;
+    free_blocks.erase(block);
+    if (remaining > 0) {
+        free_blocks[start_page + num_pages] = remaining;
+    }
+    total_free -= num_pages;
+    
+    allocations[key] = std::make_pair(start_page, num_pages);
+    return true;
+}
+
+bool ReferenceAllocator::deallocate(const std::string& key) {
+    auto it = allocations.find(key);
+    if (it == allocations.end()) {
+        return false;
+    }
+    
+    addFreeBlock(it->second.first, it->second.second);
+    total_free += it->second.second;
+    allocations.erase(it);
+    return true;
+}
+
+void ReferenceAllocator::defragment() {
+    defragmentations++;
+    
+    std::vector<std::pair<size_t, std::string>> sorted;
+    for (const auto& pair : allocations) {
+        sorted.push_back(std::make_pair(pair.second.first, pair.first));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    
+    size_t next_free = 0;
+    for (const auto& item : sorted) {
+        allocations[item.second].first = next_free;
+        next_free += allocations[item.second].second;
+    }
+    
+    free_blocks.clear();
+    total_free = total_pages - next_free;
+    if (total_free > 0) {
+        free_blocks[next_free] = total_free;
+    }
+}
+
+FragmentationStats ReferenceAllocator::getFragmentationStats() const {
+    FragmentationStats frag_stats;
+    frag_stats.total_free_pages = total_free;
+    for (const auto& block : free_blocks) {
+        frag_stats.num_free_blocks++;
+        frag_stats.largest_free_block = std::max(frag_stats.largest_free_block, block.second);
+    }
+    if (frag_stats.total_free_pages > 0) {
+        frag_stats.fragmentation_ratio = 1.0 - 
+            ((double)frag_stats.largest_free_block / frag_stats.total_free_pages);
+    }
+    return frag_stats;
+}
+
+bool CacheServerDefrag::shadowAllocation(const std::string& key, size_t num_pages, bool allocated,
+                                         std::chrono::steady_clock::time_point started) {
+    auto finished = std::chrono::steady_clock::now();
+    allocator_operations++;
+    allocator_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started).count();
+    
+    if (!reference_allocator) {
+        return allocated;
+    }
+    
+    // Allocations evicted or freed inside allocatePages were already mirrored
+    // through freePages, so both backends now see the same request
+    bool expected = reference_allocator->allocate(key, num_pages);
+    reference_allocator->operations++;
+    reference_allocator->nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - finished).count();
+    
+    if (expected != allocated || reference_allocator->totalFree() != total_free_pages) {
+        differential_mismatches++;
+        std::cerr << "[DIFFERENTIAL] Allocating " << num_pages << " pages for '" << key 
+                  << "': free list " << (allocated ? "succeeded" : "failed") << " with " 
+                  << total_free_pages << " free, reference " << (expected ? "succeeded" : "failed") 
+                  << " with " << reference_allocator->totalFree() << " free" << std::endl;
+        
+        // Resynchronize on the free list's outcome
+        if (expected && !allocated) {
+            reference_allocator->deallocate(key);
+        }
+    }
+    return allocated;
+}
+
+void CacheServerDefrag::shadowDeallocation(const std::string& key) {
+    if (reference_allocator && !reference_allocator->deallocate(key)) {
+        differential_mismatches++;
+        std::cerr << "[DIFFERENTIAL] Freed '" << key << "' unknown to the reference" << std::endl;
+    }
+}
+
+// Heavy-Hitter Tracking (Space-Saving)
+
+HeavyHitters::HeavyHitters(size_t counters) : capacity(counters) {
+    heap.reserve(counters);
+    positions.reserve(counters);
+}
+
+void HeavyHitters::siftDown(size_t pos) {
+    size_t n = heap.size();
+    while (true) {
+        size_t smallest = pos;
+        size_t left = 2 * pos + 1;
+        size_t right = left + 1;
+        if (left < n && heap[left].count < heap[smallest].count) smallest = left;
+        if (right < n && heap[right].count < heap[smallest].count) smallest = right;
+        if (smallest == pos) {
+            return;
+        }
+        std::swap(heap[pos], heap[smallest]);
+        positions[heap[pos].key] = pos;
+        positions[heap[smallest].key] = smallest;
+        pos = smallest;
+    }
+}
+
+void HeavyHitters::offer(const std::string& key, uint64_t count) {
+    auto it = positions.find(key);
+    if (it != positions.end()) {
+        // Counts only grow, so a tracked key can only move down the heap
+        heap[it->second].count += count;
+        siftDown(it->second);
+        return;
+    }
+    
+    if (heap.size() < capacity) {
+        // A new leaf may have a smaller count than its parent, so sift it up
+        positions[key] = heap.size();
+        heap.emplace_back(key, count, 0);
+        size_t pos = heap.size() - 1;
+        while (pos > 0 && heap[(pos - 1) / 2].count > heap[pos].count) {
+            std::swap(heap[pos], heap[(pos - 1) / 2]);
+            positions[heap[pos].key] = pos;
+            pos = (pos - 1) / 2;
+            positions[heap[pos].key] = pos;
+        }
+        return;
+    }
+    
+    // Full: the new key takes over the smallest counter, inheriting its
+    // count as the overestimation bound
+    positions.erase(heap[0].key);
+    uint64_t floor = heap[0].count;
+    heap[0] = HotKey(key, floor + count, floor);
+    positions[key] = 0;
+    siftDown(0);
+}
+
+std::vector<HotKey> HeavyHitters::top(size_t n) const {
+    std::vector<HotKey> result(heap);
+    std::sort(result.begin(), result.end(), [](const HotKey& a, const HotKey& b) {
+        return a.count > b.count;
+    });
+    if (result.size() > n) {
+        result.resize(n);
+    }
+    return result;
+}
+
+void HeavyHitters::clear() {
+    heap.clear();
+    positions.clear();
+}
+
+std::string CacheServerDefrag::hotKeysReport(size_t n, const std::string& client_id) {
+    // One "<key> <count> <error>" line per key, hottest first. Counts are
+    // in sampled hits; multiply by hot_key_sample_rate for an estimate.
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (!config.track_hot_keys) {
+        return "ERROR: Hot key tracking is disabled";
+    }
+    
+    std::ostringstream out;
+    for (const auto& hot : hot_keys.top(n)) {
+        out << hot.key << " " << hot.count << " " << hot.error << "\n";
+    }
+    return out.str();
+}
+
+// Miss Ratio Curves (SHARDS)
+
+MissRatioCurve::MissRatioCurve(double sample_rate, size_t max_pages)
+    : rate(std::min(1.0, std::max(sample_rate, 1.0 / 0x1000000))),
+      threshold((uint64_t)(rate * 0x1000000)),
+      bucket_pages(std::max<size_t>(1, max_pages / MRC_BUCKETS)),
+      next_slot(1),
+      histogram(MRC_BUCKETS + 1, 0), cold_refs(0), total_refs(0), all_refs(0) {}
+
+void MissRatioCurve::add(size_t slot, int64_t delta) {
+    for (; slot <= MRC_MAX_REFS; slot += slot & (~slot + 1)) {
+        tree[slot] += delta;
+    }
+}
+
+uint64_t MissRatioCurve::prefix(size_t slot) const {
+    uint64_t sum = 0;
+    for (; slot > 0; slot -= slot & (~slot + 1)) {
+        sum += tree[slot];
+    }
+    return sum;
+}
+
+void MissRatioCurve::compact() {
+    // Renumber the live slots densely in reference order. If more than
+    // half the slots are live, the oldest half of the keys is forgotten
+    // and their next references count as cold.
+    std::vector<std::pair<size_t, uint64_t>> live;
+    live.reserve(last_slot.size());
+    for (const auto& kv : last_slot) {
+        live.emplace_back(kv.second, kv.first);
+    }
+    std::sort(live.begin(), live.end());
+    size_t keep_from = live.size() > MRC_MAX_REFS / 2 ? live.size() - MRC_MAX_REFS / 2 : 0;
+    
+    std::vector<size_t> pages(slot_pages);
+    std::fill(tree.begin(), tree.end(), 0);
+    std::fill(slot_pages.begin(), slot_pages.end(), 0);
+    last_slot.clear();
+    next_slot = 1;
+    for (size_t i = keep_from; i < live.size(); ++i) {
+        size_t slot = next_slot++;
+        slot_pages[slot] = pages[live[i].first];
+        add(slot, slot_pages[slot]);
+        last_slot[live[i].second] = slot;
+    }
+}
+
+void MissRatioCurve::reference(uint64_t key_hash, size_t pages) {
+    // The slot arrays are only paid for once estimation is in use
+    if (tree.empty()) {
+        tree.assign(MRC_MAX_REFS + 1, 0);
+        slot_pages.assign(MRC_MAX_REFS + 1, 0);
+    }
+    if (next_slot > MRC_MAX_REFS) {
+        compact();
+    }
+    total_refs++;
+    size_t slot = next_slot++;
+    
+    auto it = last_slot.find(key_hash);
+    if (it == last_slot.end()) {
+        cold_refs++;
+    } else {
+        // Pages of distinct sampled keys referenced since, plus this one,
+        // scaled up to the whole key space
+        size_t prior = it->second;
+        uint64_t distance = prefix(slot - 1) - prefix(prior) + pages;
+        size_t bucket = (size_t)(distance / rate) / bucket_pages;
+        histogram[std::min(bucket, MRC_BUCKETS)]++;
+        
+        add(prior, -(int64_t)slot_pages[prior]);
+        slot_pages[prior] = 0;
+    }
+    
+    add(slot, pages);
+    slot_pages[slot] = pages;
+    last_slot[key_hash] = slot;
+}
+
+double MissRatioCurve::missRatio(size_t cache_pages) const {
+    // A reference hits if its reuse distance fits; buckets straddling the
+    // cache size count as misses
+    if (total_refs == 0) {
+        return 0.0;
+    }
+    double hits = 0;
+    for (size_t b = 0; b < MRC_BUCKETS && (b + 1) * bucket_pages <= cache_pages; ++b) {
+        hits += histogram[b];
+    }
+    
+    // SHARDS-adj: a sample that over- or under-represents the hottest keys
+    // shows up as a sampled count off its expectation; the difference is
+    // credited to the shortest distances
+    double expected = all_refs * rate;
+    if (cache_pages >= bucket_pages) {
+        hits += expected - total_refs;
+    }
+    return std::min(1.0, std::max(0.0, 1.0 - hits / expected));
+}
+
+void MissRatioCurve::clear() {
+    std::fill(tree.begin(), tree.end(), 0);
+    std::fill(slot_pages.begin(), slot_pages.end(), 0);
+    std::fill(histogram.begin(), histogram.end(), 0);
+    last_slot.clear();
+    next_slot = 1;
+    cold_refs = 0;
+    total_refs = 0;
+    all_refs = 0;
+}
+
+std::string CacheServerDefrag::missRatioReport(const std::string& client_id) {
+    // "<scale> <pages> <miss ratio>" lines around the current cache size,
+    // for the stats command
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (!config.estimate_mrc) {
+        return "ERROR: Miss ratio estimation is disabled";
+    }
+    
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+    size_t current = activePages();
+    for (double scale : {0.25, 0.5, 1.0, 2.0, 4.0}) {
+        size_t pages = (size_t)(current * scale);
+        out << scale << "x " << pages << " " << mrc.missRatio(pages) << "\n";
+    }
+    out << "samples " << mrc.samples() << "\n";
+    return out.str();
+}
+
+// Hot-Key Replication
+
+std::string CacheServerDefrag::getKeyReplicated(const std::string& key, const std::string& client_id) {
+    // Reads of replicated keys are served from this thread's copy without
+    // touching cache_mutex; everything else takes the locked path and may
+    // leave a copy behind.
+    uint64_t generation = replica_generation.load(std::memory_order_acquire);
+    if (replica_cache.owner != this) {
+        replica_cache.hits.clear();
+        replica_cache.pending_hits = 0;
+    }
+    if (replica_cache.owner != this || replica_cache.generation != generation) {
+        replica_cache.values.clear();
+        replica_cache.owner = this;
+        replica_cache.generation = generation;
+    }
+    
+    auto local = replica_cache.values.find(key);
+    if (local != replica_cache.values.end()) {
+        stats.total_requests++;
+        stats.hits++;
+        stats.replica_hits++;
+        stats.bytes_hit += local->second.size();
+        std::string response = "VALUE " + local->second;
+        
+        // Replica hits skip recordAccess; batch them for the tracker so
+        // the key keeps the count that got it replicated
+        replica_cache.hits[key]++;
+        if (++replica_cache.pending_hits >= REPLICA_FLUSH_HITS) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            flushReplicaHits();
+        }
+        return response;
+    }
+    
+    std::string response = leaseGetKey(key, client_id);
+    if (response.compare(0, 6, "VALUE ") != 0) {
+        return response;
+    }
+    
+    // Keep a copy only if no write has landed since the generation was
+    // read; the check runs under the lock that every write bumps it under.
+    // Copies skip the freshness check, so entries with deadlines get none.
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    flushReplicaHits();
+    auto it = entries.find(key);
+    if (replicated_keys.count(key) && it != entries.end() &&
+        it->second.soft_deadline_ms == 0 && it->second.hard_deadline_ms == 0 &&
+        replica_generation.load(std::memory_order_relaxed) == generation &&
+        replica_cache.values.size() < config.replica_keys) {
+        replica_cache.values[key] = response.substr(6);
+    }
+    return response;
+}
+
+void CacheServerDefrag::refreshReplicas() {
+    // Replicate the tracker's top keys. Caller holds cache_mutex.
+    if (config.track_hot_keys) {
+        // Credit at the tracker's sampling rate, like locked-path hits;
+        // the remainder waits for the next refresh
+        uint64_t rate = std::max<uint64_t>(config.hot_key_sample_rate, 1);
+        for (auto it = replica_hit_counts.begin(); it != replica_hit_counts.end();) {
+            if (it->second >= rate) {
+                hot_keys.offer(it->first, it->second / rate);
+            }
+            it->second %= rate;
+            it = it->second ? std::next(it) : replica_hit_counts.erase(it);
+        }
+    } else {
+        replica_hit_counts.clear();
+    }
+    
+    std::unordered_set<std::string> hottest;
+    for (const auto& hot : hot_keys.top(config.replica_keys)) {
+        // Entries with deadlines must go through the freshness check
+        auto it = entries.find(hot.key);
+        if (hot.count - hot.error < config.replica_min_hits || it == entries.end() ||
+            it->second.soft_deadline_ms != 0 || it->second.hard_deadline_ms != 0) {
+            continue;
+        }
+        hottest.insert(hot.key);
+        
+        // Replica hits bypass the policy, so keep replicated keys warm here
+        updatePolicy(hot.key);
+    }
+    
+    if (hottest != replicated_keys) {
+        replicated_keys.swap(hottest);
+        replica_generation++;
+    }
+}
+
+void CacheServerDefrag::flushReplicaHits() {
+    // Move this thread's replica hits to the shared tally. Caller holds
+    // cache_mutex.
+    for (const auto& local : replica_cache.hits) {
+        replica_hit_counts[local.first] += local.second;
+    }
+    replica_cache.hits.clear();
+    replica_cache.pending_hits = 0;
+}
+
+void CacheServerDefrag::invalidateReplica(const std::string& key) {
+    // Caller holds cache_mutex
+    if (replicated_keys.count(key)) {
+        replica_generation++;
+    }
+}
+
+void CacheServerDefrag::markWritten(CacheEntry& entry) {
+    // Every write to a value goes through here. Caller holds cache_mutex.
+    entry.version = ++version_clock;
+    invalidateReplica(entry.key);
+}
+
+// Defragmentation Functions
+
+FragmentationStats CacheServerDefrag::getFragmentationStats() {
+    FragmentationStats frag_stats;
+    frag_stats.total_free_pages = total_free_pages;
     
     FreeBlock* current = free_list_head;
     while (current) {
@@ -231,21 +1530,17 @@ bool CacheServerDefrag::defragment(size_t required_pages) {
     return after.largest_free_block >= required_pages;
 }
 
-void CacheServerDefrag::compactMemory() {
-    // Compact allocated blocks to the beginning of memory
-    // This creates one large contiguous free block at the end
+void CacheServerDefrag::compactMemory(bool pack_to_front) {
+    // Compact allocated blocks to the beginning of their NUMA arena
+    // This creates one large contiguous free block in each arena: at the
+    // end, or between long-lived and short-lived entries with lifetime
+    // placement (unless pack_to_front is set)
     
-    std::vector<std::pair<std::string, CacheEntry>> entries_to_move;
+    std::vector<std::vector<std::pair<std::string, CacheEntry>>> arenas(numa_nodes.size());
     for (auto& pair : entries) {
-        entries_to_move.push_back(pair);
+        arenas[arenaOf(pair.second.start_page)].push_back(pair);
     }
     
-    // Sort by current start_page
-    std::sort(entries_to_move.begin(), entries_to_move.end(),
-        [](const auto& a, const auto& b) {
-            return a.second.start_page < b.second.start_page;
-        });
-    
     // Rebuild free list
     FreeBlock* current = free_list_head;
     while (current) {
@@ -255,53 +1550,151 @@ void CacheServerDefrag::compactMemory() {
     }
     free_list_head = nullptr;
     total_free_pages = 0;
+    FreeBlock* tail = nullptr;
     
-    // Move entries to compact positions
-    size_t next_free_page = 0;
-    
-    for (auto& pair : entries_to_move) {
-        const std::string& key = pair.first;
-        CacheEntry& entry = pair.second;
-        size_t old_start = entry.start_page;
-        size_t num_pages = entry.num_pages;
+    for (size_t n = 0; n < numa_nodes.size(); ++n) {
+        std::vector<std::pair<std::string, CacheEntry>>& entries_to_move = arenas[n];
         
-        if (old_start != next_free_page) {
-            // Move data
-            std::string data = readFromPages(old_start, entry.data_size);
-            writeToPages(next_free_page, data);
-            
-            // Update entry
-            entry.start_page = next_free_page;
-            entries[key] = entry;
+        // Sort by current start_page
+        std::sort(entries_to_move.begin(), entries_to_move.end(),
+            [](const auto& a, const auto& b) {
+                return a.second.start_page < b.second.start_page;
+            });
+        if (config.hot_cold_compaction) {
+            orderHotCold(entries_to_move);
         }
         
-        // Mark pages as used
-        for (size_t i = next_free_page; i < next_free_page + num_pages; ++i) {
-            cache[i].is_free = false;
-            cache[i].block_start = next_free_page;
+        // Lay out long-lived entries from the bottom, short-lived ones from the top
+        size_t next_free_page = numa_nodes[n].first_page;
+        size_t arena_end = numa_nodes[n].first_page + numa_nodes[n].active_pages;
+        size_t top_page = arena_end;
+        bool split_layout = config.lifetime_placement && !pack_to_front;
+        
+        std::vector<size_t> new_starts(entries_to_move.size());
+        for (size_t i = entries_to_move.size(); i-- > 0; ) {
+            const CacheEntry& entry = entries_to_move[i].second;
+            if (split_layout && entry.short_lived) {
+                top_page -= entry.num_pages;
+                new_starts[i] = top_page;
+            }
+        }
+        for (size_t i = 0; i < entries_to_move.size(); ++i) {
+            const CacheEntry& entry = entries_to_move[i].second;
+            if (!(split_layout && entry.short_lived)) {
+                new_starts[i] = next_free_page;
+                next_free_page += entry.num_pages;
+            }
         }
         
-        next_free_page += num_pages;
-    }
-    
-    // Create one large free block at the end
-    if (next_free_page < TOTAL_PAGES) {
-        for (size_t i = next_free_page; i < TOTAL_PAGES; ++i) {
-            cache[i].is_free = true;
+        // Sliding everything down in address order can move data in place.
+        // Any other layout may overlap data not yet moved: stage moved values.
+        bool staged = config.hot_cold_compaction || top_page != arena_end;
+        std::vector<uint8_t> staging;
+        if (staged) {
+            for (size_t i = 0; i < entries_to_move.size(); ++i) {
+                const CacheEntry& entry = entries_to_move[i].second;
+                if (entry.start_page != new_starts[i]) {
+                    size_t offset = staging.size();
+                    staging.resize(offset + entry.data_size);
+                    readPageRun(entry.start_page, staging.data() + offset, entry.data_size);
+                }
+            }
+        }
+        
+        // Move entries to compact positions
+        size_t staged_offset = 0;
+        for (size_t i = 0; i < entries_to_move.size(); ++i) {
+            const std::string& key = entries_to_move[i].first;
+            CacheEntry& entry = entries_to_move[i].second;
+            
+            if (entry.start_page != new_starts[i]) {
+                if (staged) {
+                    writePageRun(new_starts[i], staging.data() + staged_offset, entry.data_size);
+                    staged_offset += entry.data_size;
+                } else {
+                    // Move data page by page, without a round trip through a string
+                    movePageRun(entry.start_page, new_starts[i], entry.data_size);
+                }
+                
+                // Update entry
+                entry.start_page = new_starts[i];
+                entries[key] = entry;
+                verifyEntry(entry);
+            }
+            
+            // Mark pages as used
+            markPagesUsed(entry.start_page, entry.num_pages);
         }
         
-        free_list_head = new FreeBlock(next_free_page, TOTAL_PAGES - next_free_page);
-        total_free_pages = TOTAL_PAGES - next_free_page;
+        // Create one large free block in the gap
+        if (next_free_page < top_page) {
+            for (size_t i = next_free_page; i < top_page; ++i) {
+                cache[i].is_free = true;
+            }
+            
+            FreeBlock* block = new FreeBlock(next_free_page, top_page - next_free_page);
+            block->freed_at_ms = nowMs();
+            if (tail) {
+                tail->next = block;
+                block->prev = tail;
+            } else {
+                free_list_head = block;
+            }
+            tail = block;
+            total_free_pages += block->num_pages;
+        }
+    }
+    
+    assert(checkAllocatorInvariants());
+}
+
+void CacheServerDefrag::orderHotCold(std::vector<std::pair<std::string, CacheEntry>>& arena_entries) {
+    if (arena_entries.empty()) {
+        return;
+    }
+    
+    // Hot: referenced since the policy last looked (CLOCK/SIEVE), or among
+    // the most recently accessed hot_fraction of the entries
+    std::vector<uint64_t> recency;
+    for (const auto& pair : arena_entries) {
+        recency.push_back(pair.second.last_access);
+    }
+    size_t hot_count = (size_t)(arena_entries.size() * config.hot_fraction);
+    uint64_t cutoff = UINT64_MAX;
+    if (hot_count > 0) {
+        std::nth_element(recency.begin(), recency.begin() + (hot_count - 1), recency.end(),
+                         std::greater<uint64_t>());
+        cutoff = recency[hot_count - 1];
     }
+    
+    auto is_hot = [cutoff](const CacheEntry& entry) {
+        return entry.reference_bit || entry.visited || entry.last_access >= cutoff;
+    };
+    
+    // Hot entries first, then cold ones by decreasing recency, so the
+    // coldest entries sit next to the free tail and evicting them extends it
+    std::stable_sort(arena_entries.begin(), arena_entries.end(),
+        [&is_hot](const auto& a, const auto& b) {
+            bool hot_a = is_hot(a.second);
+            bool hot_b = is_hot(b.second);
+            if (hot_a != hot_b) {
+                return hot_a;
+            }
+            return a.second.last_access > b.second.last_access;
+        });
 }
 
 // Memory Allocation with Free List
 
-bool CacheServerDefrag::allocatePages(const std::string& key, size_t data_size, const std::string& client_id) {
-    size_t required_pages = calculateRequiredPages(data_size);
+bool CacheServerDefrag::reservePages(size_t required_pages, bool short_lived, size_t& start_page) {
+    // Try best-fit allocation, local NUMA arena first. Short-lived entries
+    // are taken from the top of the highest fitting block instead.
+    FreeBlock* block = findBlockForCurrentThread(required_pages, short_lived);
     
-    // Try best-fit allocation
-    FreeBlock* block = findBestFitBlock(required_pages);
+    // Entries past their hard deadline go before anything live is evicted
+    if (!block && reapExpired() > 0) {
+        block = findBlockForCurrentThread(required_pages, short_lived);
+    }
     
     if (!block) {
         // Check if we have enough total free pages but fragmented
@@ -312,19 +1705,19 @@ bool CacheServerDefrag::allocatePages(const std::string& key, size_t data_size,
             // Try defragmentation
             if (!defragment(required_pages)) {
                 // Even after defrag, can't satisfy - try eviction
-                if (!evict(required_pages)) {
+                if (!evictBatch(required_pages)) {
                     return false;
                 }
             }
             
             // Try allocation again after defragmentation/eviction
-            block = findBestFitBlock(required_pages);
+            block = findBlockForCurrentThread(required_pages, short_lived);
         } else {
             // Not enough total free pages - evict
-            if (!evict(required_pages)) {
+            if (!evictBatch(required_pages)) {
                 return false;
             }
-            block = findBestFitBlock(required_pages);
+            block = findBlockForCurrentThread(required_pages, short_lived);
         }
     }
     
@@ -333,29 +1726,60 @@ bool CacheServerDefrag::allocatePages(const std::string& key, size_t data_size,
     }
     
     // Allocate from the block
-    size_t start_page = block->start_page;
-    splitBlock(block, required_pages);
+    if (short_lived) {
+        start_page = block->start_page + block->num_pages - required_pages;
+        splitBlockTail(block, required_pages);
+        stats.short_lived_allocs++;
+    } else {
+        start_page = block->start_page;
+        splitBlock(block, required_pages);
+    }
     
     // Mark pages as used
-    for (size_t i = start_page; i < start_page + required_pages; ++i) {
-        cache[i].is_free = false;
-        cache[i].block_start = start_page;
+    markPagesUsed(start_page, required_pages);
+    
+    // Wake the evictor before the next SET has to evict inline
+    if (config.proactive_eviction && total_free_pages < scaleToActive(config.free_low_watermark)) {
+        evictor_wakeup = true;
+        evictor_cv.notify_one();
+    }
+    return true;
+}
+
+bool CacheServerDefrag::allocatePages(const std::string& key, size_t data_size, const std::string& client_id) {
+    auto started = std::chrono::steady_clock::now();
+    size_t required_pages = calculateRequiredPages(data_size);
+    bool short_lived = config.lifetime_placement && predictShortLived(key);
+    
+    size_t start_page;
+    if (!reservePages(required_pages, short_lived, start_page)) {
+        return shadowAllocation(key, required_pages, false, started);
     }
     
     // Create entry
     CacheEntry entry;
     entry.key = key;
     entry.client_id = client_id;
+    entry.key_hash = hashKey(key.data(), key.size());
     entry.start_page = start_page;
     entry.num_pages = required_pages;
     entry.data_size = data_size;
     entry.insertion_order = fifo_counter++;
+    entry.last_access = ++access_clock;
+    markWritten(entry);
+    entry.short_lived = short_lived;
     entry.visited = false;
     entry.reference_bit = false;
     
     entries[key] = entry;
     
-    return true;
+    // A fill is the miss side of the reference stream
+    if (config.estimate_mrc) {
+        mrc.offer(entry.key_hash, required_pages);
+    }
+    
+    assert(checkAllocatorInvariants());
+    return shadowAllocation(key, required_pages, true, started);
 }
 
 void CacheServerDefrag::freePages(const std::string& key) {
@@ -365,6 +1789,10 @@ void CacheServerDefrag::freePages(const std::string& key) {
     size_t start_page = it->second.start_page;
     size_t num_pages = it->second.num_pages;
     
+    if (config.lifetime_placement) {
+        recordLifetime(it->second);
+    }
+    
     // Mark pages as free
     for (size_t i = start_page; i < start_page + num_pages; ++i) {
         cache[i].is_free = true;
@@ -372,41 +1800,1453 @@ void CacheServerDefrag::freePages(const std::string& key) {
     
     // Add to free list (with automatic coalescing)
     addToFreeList(start_page, num_pages);
+    shadowDeallocation(key);
+    
+    assert(checkAllocatorInvariants());
 }
 
-size_t CacheServerDefrag::calculateRequiredPages(size_t data_size) {
-    return (data_size + PAGE_SIZE - 1) / PAGE_SIZE;
-}
-
-void CacheServerDefrag::printFreeList() {
-    std::cout << "\n[FREE LIST]" << std::endl;
-    std::cout << "Total free pages: " << total_free_pages << std::endl;
+bool CacheServerDefrag::resizeInPlace(CacheEntry& entry, size_t new_data_size) {
+    size_t old_pages = entry.num_pages;
+    size_t new_pages = std::max<size_t>(1, calculateRequiredPages(new_data_size));
+    size_t end_page = entry.start_page + old_pages;
     
-    int count = 0;
-    FreeBlock* current = free_list_head;
-    while (current) {
-        std::cout << "  Block " << count++ << ": "
-                  << "start=" << current->start_page << ", "
-                  << "pages=" << current->num_pages << std::endl;
-        current = current->next;
+    if (new_pages < old_pages) {
+        // Shrink: return the tail pages to the free list
+        for (size_t i = entry.start_page + new_pages; i < end_page; ++i) {
+            cache[i].is_free = true;
+        }
+        addToFreeList(entry.start_page + new_pages, old_pages - new_pages);
+    } else if (new_pages > old_pages) {
+        // Grow: only into a free block that starts right after the entry
+        size_t needed = new_pages - old_pages;
+        FreeBlock* block = free_list_head;
+        while (block && block->start_page < end_page) {
+            block = block->next;
+        }
+        if (!block || block->start_page != end_page || block->num_pages < needed ||
+            isArenaBoundary(end_page)) {
+            return false;
+        }
+        splitBlock(block, needed);
+        markPagesUsed(entry.start_page, new_pages);
     }
-    std::cout << "Total blocks: " << count << "\n" << std::endl;
-}
-
-void CacheServerDefrag::printFragmentationStats() {
-    FragmentationStats stats = getFragmentationStats();
+    
+    if (new_pages != old_pages && reference_allocator) {
+        // Keep the reference model's page accounting in step
+        reference_allocator->deallocate(entry.key);
+        reference_allocator->allocate(entry.key, new_pages);
+    }
+    
+    entry.num_pages = new_pages;
+    entry.data_size = new_data_size;
+    
+    assert(checkAllocatorInvariants());
+    return true;
+}
+
+bool CacheServerDefrag::tryUpdateInPlace(const std::string& key, const std::string& value) {
+    // Rewrite the value inside the entry's current page run (shrinking or
+    // growing it at the tail) instead of freeing and reallocating it.
+    // Caller holds cache_mutex; returns false when updateKey must reallocate.
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+    
+    CacheEntry& entry = it->second;
+    if (!resizeInPlace(entry, value.size())) {
+        return false;
+    }
+    
+    writeToPages(entry.start_page, value);
+    sealEntry(entry);
+    markWritten(entry);
+    stats.inplace_updates++;
+    return true;
+}
+
+bool CacheServerDefrag::relocateEntry(const std::string& key, size_t new_data_size) {
+    // Move an entry's value into a new page run sized for new_data_size,
+    // keeping its policy state. Caller holds cache_mutex.
+    size_t new_pages = std::max<size_t>(1, calculateRequiredPages(new_data_size));
+    size_t new_start;
+    if (!reservePages(new_pages, false, new_start)) {
+        return false;
+    }
+    
+    // Defragmentation may have moved the entry, eviction may have removed it
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        for (size_t i = new_start; i < new_start + new_pages; ++i) {
+            cache[i].is_free = true;
+        }
+        addToFreeList(new_start, new_pages);
+        return false;
+    }
+    
+    CacheEntry& entry = it->second;
+    movePageRun(entry.start_page, new_start, std::min(entry.data_size, new_data_size));
+    
+    for (size_t i = entry.start_page; i < entry.start_page + entry.num_pages; ++i) {
+        cache[i].is_free = true;
+    }
+    addToFreeList(entry.start_page, entry.num_pages);
+    
+    if (reference_allocator) {
+        reference_allocator->deallocate(key);
+        reference_allocator->allocate(key, new_pages);
+    }
+    
+    entry.start_page = new_start;
+    entry.num_pages = new_pages;
+    entry.data_size = new_data_size;
+    
+    assert(checkAllocatorInvariants());
+    return true;
+}
+
+size_t CacheServerDefrag::calculateRequiredPages(size_t data_size) {
+    return (data_size + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+// Page Run Copies
+
+void CacheServerDefrag::writePageRange(size_t start_page, size_t offset, const uint8_t* src, size_t len) {
+    // Touch only the pages covering [offset, offset + len)
+    size_t page = start_page + offset / PAGE_SIZE;
+    size_t page_offset = offset % PAGE_SIZE;
+    while (len > 0) {
+        size_t chunk = std::min(len, PAGE_SIZE - page_offset);
+        std::memcpy(cache[page].data + page_offset, src, chunk);
+        src += chunk;
+        len -= chunk;
+        page_offset = 0;
+        ++page;
+    }
+}
+
+void CacheServerDefrag::readPageRange(size_t start_page, size_t offset, uint8_t* dst, size_t len) {
+    size_t page = start_page + offset / PAGE_SIZE;
+    size_t page_offset = offset % PAGE_SIZE;
+    while (len > 0) {
+        size_t chunk = std::min(len, PAGE_SIZE - page_offset);
+        std::memcpy(dst, cache[page].data + page_offset, chunk);
+        dst += chunk;
+        len -= chunk;
+        page_offset = 0;
+        ++page;
+    }
+}
+
+void CacheServerDefrag::writePageRun(size_t start_page, const uint8_t* src, size_t len) {
+    bool streaming = len >= NT_COPY_THRESHOLD;
+    for (size_t page = start_page; len > 0; ++page) {
+        size_t chunk = std::min(len, PAGE_SIZE);
+        if (streaming) {
+            stream_copy(cache[page].data, src, chunk);
+        } else {
+            std::memcpy(cache[page].data, src, chunk);
+        }
+        src += chunk;
+        len -= chunk;
+    }
+}
+
+void CacheServerDefrag::readPageRun(size_t start_page, uint8_t* dst, size_t len) {
+    for (size_t page = start_page; len > 0; ++page) {
+        size_t chunk = std::min(len, PAGE_SIZE);
+        std::memcpy(dst, cache[page].data, chunk);
+        dst += chunk;
+        len -= chunk;
+    }
+}
+
+void CacheServerDefrag::movePageRun(size_t from_page, size_t to_page, size_t len) {
+    // Compaction only moves runs towards lower pages, so copying in
+    // ascending page order never overwrites a page that is still to be read
+    bool streaming = len >= NT_COPY_THRESHOLD;
+    for (size_t i = 0; len > 0; ++i) {
+        size_t chunk = std::min(len, PAGE_SIZE);
+        if (streaming) {
+            stream_copy(cache[to_page + i].data, cache[from_page + i].data, chunk);
+        } else {
+            std::memcpy(cache[to_page + i].data, cache[from_page + i].data, chunk);
+        }
+        len -= chunk;
+    }
+}
+
+// Value Checksums
+
+uint32_t CacheServerDefrag::checksumPages(size_t start_page, size_t data_size) {
+    uint32_t crc = 0;
+    for (size_t page = start_page; data_size > 0; ++page) {
+        size_t chunk = std::min(data_size, PAGE_SIZE);
+        crc = crc32c(crc, cache[page].data, chunk);
+        data_size -= chunk;
+    }
+    return crc;
+}
+
+void CacheServerDefrag::sealEntry(CacheEntry& entry) {
+    if (config.verify_checksums) {
+        entry.checksum = checksumPages(entry.start_page, entry.data_size);
+    }
+}
+
+bool CacheServerDefrag::verifyEntry(const CacheEntry& entry) {
+    if (!config.verify_checksums) {
+        return true;
+    }
+    
+    uint32_t actual = checksumPages(entry.start_page, entry.data_size);
+    if (actual != entry.checksum) {
+        stats.checksum_failures++;
+        std::cerr << "[CHECKSUM] Mismatch for key '" << entry.key << "' at page " 
+                  << entry.start_page << ": expected " << std::hex << entry.checksum 
+                  << ", got " << actual << std::dec << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Background Scrubber
+
+void CacheServerDefrag::startScrubber() {
+    if (scrubber_running || config.scrub_pages_per_sec == 0) {
+        return;
+    }
+    scrubber_running = true;
+    scrubber_thread = std::thread(&CacheServerDefrag::scrubberThreadFunction, this);
+    std::cout << "Scrubber started: " << config.scrub_pages_per_sec << " pages/sec" << std::endl;
+}
+
+void CacheServerDefrag::stopScrubber() {
+    {
+        std::lock_guard<std::mutex> lock(scrub_mutex);
+        scrubber_running = false;
+    }
+    scrub_cv.notify_all();
+    if (scrubber_thread.joinable()) {
+        scrubber_thread.join();
+    }
+}
+
+void CacheServerDefrag::scrubberThreadFunction() {
+    // Pause between passes, long enough for one batch of the page budget
+    auto batch_pause = std::chrono::microseconds(
+        SCRUB_BATCH_PAGES * 1000000 / config.scrub_pages_per_sec);
+    
+    while (scrubber_running) {
+        std::vector<std::string> keys;
+        size_t errors = 0;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            errors += verifyFreeList();
+            keys.reserve(entries.size());
+            for (const auto& pair : entries) {
+                keys.push_back(pair.first);
+            }
+        }
+        
+        // Walk the used page runs at most SCRUB_BATCH_PAGES per lock hold,
+        // so foreground requests never wait on the scrubber for long. A
+        // large value is checksummed across several holds; the cursor
+        // remembers how far it got.
+        size_t next = 0;
+        size_t done = 0;         // Pages of keys[next] already verified
+        uint32_t crc = 0;        // CRC32C over those pages
+        uint64_t version = 0;    // Entry version and location when it was started
+        size_t start_page = 0;
+        while (scrubber_running && next < keys.size()) {
+            size_t pages = 0;
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                while (next < keys.size() && pages < SCRUB_BATCH_PAGES) {
+                    auto it = entries.find(keys[next]);
+                    if (it == entries.end() || 
+                        (done > 0 && (it->second.version != version || 
+                                      it->second.start_page != start_page))) {
+                        // Deleted, rewritten or moved since it was started;
+                        // the writer sealed the new contents
+                        next++;
+                        done = 0;
+                        continue;
+                    }
+                    
+                    const CacheEntry& entry = it->second;
+                    if (done == 0) {
+                        crc = 0;
+                        version = entry.version;
+                        start_page = entry.start_page;
+                    }
+                    size_t count = std::min(SCRUB_BATCH_PAGES - pages, entry.num_pages - done);
+                    errors += scrubPages(entry, done, count, crc);
+                    done += count;
+                    pages += count;
+                    if (done == entry.num_pages) {
+                        next++;
+                        done = 0;
+                    }
+                }
+            }
+            
+            // Pace by the pages actually verified
+            std::unique_lock<std::mutex> lock(scrub_mutex);
+            scrub_cv.wait_for(lock, std::chrono::microseconds(pages * 1000000 / config.scrub_pages_per_sec),
+                              [this] { return !scrubber_running; });
+        }
+        
+        stats.scrub_passes++;
+        stats.scrub_errors += errors;
+        if (errors > 0) {
+            std::cerr << "[SCRUBBER] Pass found " << errors << " inconsistencies" << std::endl;
+        }
+        
+        std::unique_lock<std::mutex> lock(scrub_mutex);
+        scrub_cv.wait_for(lock, batch_pause, [this] { return !scrubber_running; });
+    }
+}
+
+size_t CacheServerDefrag::scrubPages(const CacheEntry& entry, size_t first, size_t count, uint32_t& crc) {
+    // Verify pages [first, first + count) of the entry, extending crc over
+    // their bytes; the checksum is compared once the last page is done
+    size_t errors = 0;
+    
+    for (size_t i = entry.start_page + first; i < entry.start_page + first + count; ++i) {
+        if (cache[i].is_free || cache[i].block_start != entry.start_page) {
+            std::cerr << "[SCRUBBER] Page " << i << " of key '" << entry.key 
+                      << "' is marked free or belongs to another block" << std::endl;
+            errors++;
+            break;
+        }
+    }
+    
+    if (!config.verify_checksums) {
+        return errors;
+    }
+    for (size_t page = first; page < first + count && page * PAGE_SIZE < entry.data_size; ++page) {
+        size_t chunk = std::min(PAGE_SIZE, entry.data_size - page * PAGE_SIZE);
+        crc = crc32c(crc, cache[entry.start_page + page].data, chunk);
+    }
+    
+    if (first + count == entry.num_pages && crc != entry.checksum) {
+        stats.checksum_failures++;
+        std::cerr << "[CHECKSUM] Mismatch for key '" << entry.key << "' at page " 
+                  << entry.start_page << ": expected " << std::hex << entry.checksum 
+                  << ", got " << crc << std::dec << std::endl;
+        errors++;
+    }
+    return errors;
+}
+
+size_t CacheServerDefrag::verifyFreeList() {
+    size_t errors = 0;
+    size_t listed_pages = 0;
+    
+    FreeBlock* current = free_list_head;
+    while (current) {
+        for (size_t i = current->start_page; i < current->start_page + current->num_pages; ++i) {
+            if (!cache[i].is_free) {
+                std::cerr << "[SCRUBBER] Free block at " << current->start_page 
+                          << " covers used page " << i << std::endl;
+                errors++;
+                break;
+            }
+        }
+        listed_pages += current->num_pages;
+        current = current->next;
+    }
+    
+    size_t flagged_pages = 0;
+    for (size_t i = 0; i < TOTAL_PAGES; ++i) {
+        if (cache[i].is_free) {
+            flagged_pages++;
+        }
+    }
+    
+    if (flagged_pages != listed_pages || listed_pages != total_free_pages) {
+        std::cerr << "[SCRUBBER] Free page mismatch: " << flagged_pages << " flagged, " 
+                  << listed_pages << " listed, " << total_free_pages << " counted" << std::endl;
+        errors++;
+    }
+    return errors;
+}
+
+// Adaptive Cache Sizing
+
+void CacheServerDefrag::releasePageMemory(size_t start_page, size_t num_pages, bool lazy) {
+    // Only the OS pages fully inside each data array are released; page
+    // headers (is_free, block_start) stay resident and keep their values
+    static const uintptr_t os_page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    int advice = MADV_DONTNEED;
+#ifdef MADV_FREE
+    if (lazy) {
+        advice = MADV_FREE;
+    }
+#else
+    (void)lazy;
+#endif
+    
+    for (size_t i = start_page; i < start_page + num_pages; ++i) {
+        if (cache[i].released) {
+            continue;
+        }
+        uintptr_t begin = ((uintptr_t)cache[i].data + os_page - 1) & ~(os_page - 1);
+        uintptr_t end = ((uintptr_t)cache[i].data + PAGE_SIZE) & ~(os_page - 1);
+        if (end > begin && madvise((void*)begin, end - begin, advice) == 0) {
+            cache[i].released = true;
+            stats.pages_released++;
+        }
+    }
+}
+
+void CacheServerDefrag::releaseIdleFreeBlocks() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    uint64_t now = nowMs();
+    
+    for (FreeBlock* block = free_list_head; block; block = block->next) {
+        if (block->num_pages >= config.release_threshold_pages &&
+            now - block->freed_at_ms >= (uint64_t)config.release_grace_ms) {
+            releasePageMemory(block->start_page, block->num_pages, config.release_lazily);
+        }
+    }
+}
+
+void CacheServerDefrag::retireArenaTail(size_t node, size_t target_pages) {
+    // Drop the free pages between target_pages and the current end of the
+    // arena from the free list; the caller made sure they are all free
+    NumaNode& arena = numa_nodes[node];
+    size_t target_end = arena.first_page + target_pages;
+    size_t arena_end = arena.first_page + arena.active_pages;
+    
+    FreeBlock* block = free_list_head;
+    while (block && block->start_page + block->num_pages < arena_end) {
+        block = block->next;
+    }
+    
+    if (block && block->start_page + block->num_pages == arena_end && block->start_page <= target_end) {
+        size_t retired = arena_end - target_end;
+        if (block->start_page == target_end) {
+            removeFromFreeList(block);
+            delete block;
+        } else {
+            block->num_pages -= retired;
+            total_free_pages -= retired;
+        }
+        
+        for (size_t i = target_end; i < arena_end; ++i) {
+            cache[i].is_free = false;
+        }
+        releasePageMemory(target_end, retired);
+        arena.active_pages = target_pages;
+    }
+}
+
+size_t CacheServerDefrag::resizeCache(size_t target_pages) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    
+    target_pages = std::max(target_pages, numa_nodes.size());
+    target_pages = std::min(target_pages, TOTAL_PAGES);
+    size_t current_pages = activePages();
+    if (target_pages == current_pages) {
+        return current_pages;
+    }
+    
+    // The reference model has a fixed size
+    if (reference_allocator) {
+        std::cerr << "[RESIZE] Differential check disabled" << std::endl;
+        reference_allocator.reset();
+    }
+    
+    // Spread the new size over the arenas in proportion to their capacity
+    std::vector<size_t> targets(numa_nodes.size());
+    size_t assigned = 0;
+    for (size_t n = 0; n < numa_nodes.size(); ++n) {
+        targets[n] = std::max<size_t>(1, numa_nodes[n].num_pages * target_pages / TOTAL_PAGES);
+        assigned += targets[n];
+    }
+    for (size_t n = 0; assigned < target_pages && n < numa_nodes.size(); ++n) {
+        size_t extra = std::min(target_pages - assigned, numa_nodes[n].num_pages - targets[n]);
+        targets[n] += extra;
+        assigned += extra;
+    }
+    
+    if (target_pages > current_pages) {
+        // Grow: hand the reactivated pages to the free list
+        for (size_t n = 0; n < numa_nodes.size(); ++n) {
+            NumaNode& node = numa_nodes[n];
+            if (targets[n] > node.active_pages) {
+                size_t start = node.first_page + node.active_pages;
+                size_t count = targets[n] - node.active_pages;
+                for (size_t i = start; i < start + count; ++i) {
+                    cache[i].is_free = true;
+                }
+                node.active_pages = targets[n];
+                addToFreeList(start, count);
+            }
+        }
+    } else {
+        // Shrink: evict until the remaining entries fit, then compact them
+        // into the leading part of each arena
+        size_t used_pages = current_pages - total_free_pages;
+        if (used_pages > target_pages) {
+            evictBatch(current_pages - target_pages, false);
+        }
+        compactMemory(true);
+        
+        // Move entries that still sit beyond their arena's new end into
+        // free space below the new end of another arena
+        for (size_t n = 0; n < numa_nodes.size(); ++n) {
+            size_t target_end = numa_nodes[n].first_page + targets[n];
+            std::vector<std::string> overflow;
+            for (const auto& pair : entries) {
+                if (arenaOf(pair.second.start_page) == n && 
+                    pair.second.start_page + pair.second.num_pages > target_end) {
+                    overflow.push_back(pair.first);
+                }
+            }
+            
+            for (const std::string& key : overflow) {
+                CacheEntry& entry = entries[key];
+                FreeBlock* best = nullptr;
+                for (FreeBlock* block = free_list_head; block; block = block->next) {
+                    size_t m = arenaOf(block->start_page);
+                    if (m != n && block->num_pages >= entry.num_pages &&
+                        block->start_page + entry.num_pages <= numa_nodes[m].first_page + targets[m] &&
+                        (!best || block->num_pages < best->num_pages)) {
+                        best = block;
+                    }
+                }
+                if (!best) {
+                    continue;
+                }
+                
+                size_t old_start = entry.start_page;
+                size_t new_start = best->start_page;
+                splitBlock(best, entry.num_pages);
+                markPagesUsed(new_start, entry.num_pages);
+                movePageRun(old_start, new_start, entry.data_size);
+                for (size_t i = old_start; i < old_start + entry.num_pages; ++i) {
+                    cache[i].is_free = true;
+                }
+                addToFreeList(old_start, entry.num_pages);
+                entry.start_page = new_start;
+                verifyEntry(entry);
+            }
+        }
+        
+        // Retire the tails that are now free. An arena whose entries could
+        // not all be moved only shrinks down to its last entry.
+        for (size_t n = 0; n < numa_nodes.size(); ++n) {
+            size_t arena_end = numa_nodes[n].first_page + numa_nodes[n].active_pages;
+            size_t used_end = numa_nodes[n].first_page + targets[n];
+            for (const auto& pair : entries) {
+                if (arenaOf(pair.second.start_page) == n) {
+                    used_end = std::max(used_end, pair.second.start_page + pair.second.num_pages);
+                }
+            }
+            if (used_end < arena_end) {
+                retireArenaTail(n, used_end - numa_nodes[n].first_page);
+            }
+        }
+    }
+    
+    stats.resizes++;
+    size_t achieved = activePages();
+    std::cout << "[RESIZE] Cache resized from " << current_pages << " to " << achieved 
+              << " pages (requested " << target_pages << ")" << std::endl;
+    
+    assert(checkAllocatorInvariants());
+    return achieved;
+}
+
+bool CacheServerDefrag::readMemoryPressure(double& some_avg10) {
+    std::vector<std::string> paths;
+    if (!config.psi_path.empty()) {
+        paths.push_back(config.psi_path);
+    } else {
+        paths.push_back("/sys/fs/cgroup/memory.pressure");
+        paths.push_back("/proc/pressure/memory");
+    }
+    
+    for (const std::string& path : paths) {
+        std::ifstream file(path);
+        std::string line;
+        // Format: "some avg10=1.23 avg60=0.50 avg300=0.10 total=12345"
+        while (std::getline(file, line)) {
+            if (std::sscanf(line.c_str(), "some avg10=%lf", &some_avg10) == 1) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void CacheServerDefrag::startMemoryMonitor() {
+    if (monitor_running) {
+        return;
+    }
+    monitor_running = true;
+    monitor_thread = std::thread(&CacheServerDefrag::monitorThreadFunction, this);
+}
+
+void CacheServerDefrag::stopMemoryMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(monitor_mutex);
+        monitor_running = false;
+    }
+    monitor_cv.notify_all();
+    if (monitor_thread.joinable()) {
+        monitor_thread.join();
+    }
+}
+
+void CacheServerDefrag::monitorThreadFunction() {
+    size_t step = std::max<size_t>(1, (size_t)(TOTAL_PAGES * config.resize_step));
+    uint64_t last_pressure_check = 0;
+    
+    while (monitor_running) {
+        if (config.release_free_pages) {
+            releaseIdleFreeBlocks();
+        }
+        
+        // PSI avg10 moves slowly, check it every 5 seconds
+        double pressure;
+        uint64_t now = nowMs();
+        if (config.adapt_to_memory_pressure && now - last_pressure_check >= 5000 &&
+            readMemoryPressure(pressure)) {
+            last_pressure_check = now;
+            size_t current_pages;
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                current_pages = activePages();
+            }
+            
+            if (pressure > config.psi_shrink_above && current_pages > config.min_cache_pages) {
+                std::cout << "[RESIZE] Memory pressure " << pressure << "%, shrinking" << std::endl;
+                resizeCache(std::max(config.min_cache_pages, current_pages - std::min(step, current_pages)));
+            } else if (pressure < config.psi_grow_below && current_pages < TOTAL_PAGES) {
+                resizeCache(current_pages + step);
+            }
+        }
+        
+        std::unique_lock<std::mutex> lock(monitor_mutex);
+        monitor_cv.wait_for(lock, std::chrono::milliseconds(RELEASE_SCAN_INTERVAL_MS), 
+                            [this] { return !monitor_running; });
+    }
+}
+
+// Background Eviction
+
+void CacheServerDefrag::startEvictor() {
+    if (evictor_running) {
+        return;
+    }
+    evictor_running = true;
+    evictor_thread = std::thread(&CacheServerDefrag::evictorThreadFunction, this);
+}
+
+void CacheServerDefrag::stopEvictor() {
+    {
+        std::lock_guard<std::mutex> lock(evictor_mutex);
+        evictor_running = false;
+    }
+    evictor_cv.notify_all();
+    if (evictor_thread.joinable()) {
+        evictor_thread.join();
+    }
+}
+
+void CacheServerDefrag::evictorThreadFunction() {
+    // Largest-block attempts that fall short back off exponentially, so an
+    // unreachable target does not compact under cache_mutex on every tick
+    uint64_t backoff_ms = 0;
+    uint64_t next_block_attempt = 0;
+    
+    while (evictor_running) {
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            uint64_t evictions_before = stats.evictions;
+            
+            // Total headroom: the victims' runs need not be contiguous
+            if (total_free_pages < scaleToActive(config.free_low_watermark)) {
+                evictBatch(scaleToActive(config.free_high_watermark), false);
+            }
+            
+            // Largest block: compact only when one arena holds enough free
+            // pages for the target, evict when there are too few overall
+            uint64_t now = nowMs();
+            size_t target = scaleToActive(config.min_largest_free_block);
+            if (now >= next_block_attempt && getFragmentationStats().largest_free_block < target) {
+                if (largestArenaFree() >= target) {
+                    defragment(target);
+                } else if (total_free_pages < target) {
+                    evictBatch(target, false);
+                }
+                
+                if (getFragmentationStats().largest_free_block < target) {
+                    backoff_ms = std::min(EVICTOR_MAX_BACKOFF_MS, 
+                                          std::max<uint64_t>(config.evictor_interval_ms, backoff_ms * 2));
+                    next_block_attempt = now + backoff_ms;
+                } else {
+                    backoff_ms = 0;
+                }
+            }
+            stats.background_evictions += stats.evictions - evictions_before;
+        }
+        
+        std::unique_lock<std::mutex> lock(evictor_mutex);
+        evictor_cv.wait_for(lock, std::chrono::milliseconds(config.evictor_interval_ms), 
+                            [this] { return !evictor_running || evictor_wakeup; });
+        evictor_wakeup = false;
+    }
+}
+
+// Access Tracking
+
+void CacheServerDefrag::recordAccess(CacheEntry& entry) {
+    // Called on every hit, next to updatePolicy
+    entry.last_access = ++access_clock;
+    
+    if (config.track_hot_keys &&
+        (config.hot_key_sample_rate <= 1 || access_clock % config.hot_key_sample_rate == 0)) {
+        hot_keys.offer(entry.key);
+    }
+    if (config.estimate_mrc) {
+        mrc.offer(entry.key_hash, entry.num_pages);
+    }
+    if (config.replicate_hot_keys && access_clock % REPLICA_REFRESH_ACCESSES == 0) {
+        refreshReplicas();
+    }
+}
+
+// APPEND and GETRANGE
+
+std::string CacheServerDefrag::appendKey(const std::string& key, const std::string& value, 
+                                         const std::string& client_id) {
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    
+    // Extending a corrupted value would carry the damage into a new checksum
+    CacheEntry* found = findLiveEntry(key, nowMs());
+    if (!found || !verifyEntry(*found)) {
+        return "NOT_FOUND";
+    }
+    
+    // Grow into the adjacent free pages when possible, otherwise move the
+    // value once into a larger run
+    size_t old_size = found->data_size;
+    size_t new_size = old_size + value.size();
+    if (!resizeInPlace(*found, new_size) && !relocateEntry(key, new_size)) {
+        return "ERROR: Out of memory";
+    }
+    
+    // Only the pages receiving the appended bytes are written
+    CacheEntry& entry = entries[key];
+    writePageRange(entry.start_page, old_size, (const uint8_t*)value.data(), value.size());
+    if (config.verify_checksums) {
+        entry.checksum = crc32c(entry.checksum, (const uint8_t*)value.data(), value.size());
+    }
+    markWritten(entry);
+    
+    stats.updates++;
+    recordAccess(entry);
+    updatePolicy(key);
+    return "OK";
+}
+
+std::string CacheServerDefrag::getRange(const std::string& key, size_t offset, size_t length, 
+                                        const std::string& client_id) {
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stats.total_requests++;
+    
+    CacheEntry* found = findLiveEntry(key, nowMs());
+    if (!found) {
+        stats.misses++;
+        return "NOT_FOUND";
+    }
+    stats.hits++;
+    
+    // Ranges past the end are clamped like Redis GETRANGE. The checksum
+    // covers the whole value and is not verified for partial reads.
+    CacheEntry& entry = *found;
+    offset = std::min(offset, entry.data_size);
+    length = std::min(length, entry.data_size - offset);
+    
+    stats.bytes_hit += length;
+    std::string result(length, '\0');
+    readPageRange(entry.start_page, offset, (uint8_t*)&result[0], length);
+    
+    recordAccess(entry);
+    updatePolicy(key);
+    return result;
+}
+
+// Counters and Compare-and-Swap
+
+bool CacheServerDefrag::storeValue(const std::string& key, const std::string& value) {
+    // Replace an existing value, in place when the run allows it.
+    // Caller holds cache_mutex.
+    if (tryUpdateInPlace(key, value)) {
+        return true;
+    }
+    if (!relocateEntry(key, value.size())) {
+        return false;
+    }
+    
+    CacheEntry& entry = entries[key];
+    writeToPages(entry.start_page, value);
+    sealEntry(entry);
+    markWritten(entry);
+    return true;
+}
+
+std::string CacheServerDefrag::incrKey(const std::string& key, int64_t delta, const std::string& client_id) {
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    
+    // The result is re-sealed, so a corrupted value must not be parsed
+    CacheEntry* found = findLiveEntry(key, nowMs());
+    if (!found || !verifyEntry(*found)) {
+        return "NOT_FOUND";
+    }
+    
+    // Values are decimal signed 64-bit integers; anything else is rejected.
+    // strtoll would skip leading whitespace and a '+', and stop at an
+    // embedded NUL, so the whole value must be consumed from a digit or '-'.
+    std::string current = readFromPages(found->start_page, found->data_size);
+    if (current.empty() || current.size() > 20 || 
+        !(current[0] == '-' || (current[0] >= '0' && current[0] <= '9'))) {
+        return "ERROR: Value is not an integer";
+    }
+    errno = 0;
+    char* end = nullptr;
+    long long number = std::strtoll(current.c_str(), &end, 10);
+    if (errno != 0 || end != current.data() + current.size()) {
+        return "ERROR: Value is not an integer";
+    }
+    
+    long long result;
+    if (__builtin_add_overflow(number, (long long)delta, &result)) {
+        return "ERROR: Increment would overflow";
+    }
+    
+    std::string updated = std::to_string(result);
+    if (!storeValue(key, updated)) {
+        return "ERROR: Out of memory";
+    }
+    
+    stats.updates++;
+    recordAccess(entries[key]);
+    updatePolicy(key);
+    return updated;
+}
+
+std::string CacheServerDefrag::getsKey(const std::string& key, const std::string& client_id) {
+    // GET that also returns the version stamp to pass back with CAS
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stats.total_requests++;
+    
+    CacheEntry* found = findLiveEntry(key, nowMs());
+    
+    // Never serve a corrupted value
+    if (!found || !verifyEntry(*found)) {
+        stats.misses++;
+        return "NOT_FOUND";
+    }
+    stats.hits++;
+    
+    CacheEntry& entry = *found;
+    stats.bytes_hit += entry.data_size;
+    std::string value = readFromPages(entry.start_page, entry.data_size);
+    recordAccess(entry);
+    updatePolicy(key);
+    return std::to_string(entry.version) + " " + value;
+}
+
+std::string CacheServerDefrag::casKey(const std::string& key, const std::string& value, 
+                                      uint64_t expected_version, const std::string& client_id) {
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    
+    // A corrupted value is missing, as in GETS
+    CacheEntry* found = findLiveEntry(key, nowMs());
+    if (!found || !verifyEntry(*found)) {
+        return "NOT_FOUND";
+    }
+    if (found->version != expected_version) {
+        return "EXISTS";
+    }
+    
+    if (!storeValue(key, value)) {
+        return "ERROR: Out of memory";
+    }
+    
+    stats.updates++;
+    recordAccess(entries[key]);
+    updatePolicy(key);
+    return "OK";
+}
+
+// Fill Leases
+
+std::string CacheServerDefrag::leaseGetKey(const std::string& key, const std::string& client_id) {
+    // GET that hands out at most one fill lease per missed key. The first
+    // client to miss gets "LEASE <token>" and should fetch from the backend;
+    // the others get "WAIT" and retry shortly instead of filling as well.
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stats.total_requests++;
+    
+    uint64_t now = nowMs();
+    CacheEntry* found = findLiveEntry(key, now);
+    
+    // Never serve a corrupted value; the miss path below leases a refill
+    if (found && !verifyEntry(*found)) {
+        found = nullptr;
+    }
+    if (found) {
+        CacheEntry& entry = *found;
+        stats.hits++;
+        stats.bytes_hit += entry.data_size;
+        std::string value = readFromPages(entry.start_page, entry.data_size);
+        recordAccess(entry);
+        updatePolicy(key);
+        if (entry.soft_deadline_ms == 0 || entry.soft_deadline_ms > now) {
+            return "VALUE " + value;
+        }
+        
+        // Past the soft deadline: serve it anyway, and let exactly one
+        // client refresh it through the lease
+        stats.stale_hits++;
+        auto lease = leases.find(key);
+        if (lease != leases.end() && lease->second.expires_ms > now) {
+            return "STALE " + value;
+        }
+        uint64_t token = ++lease_counter;
+        leases[key] = FillLease(token, now + config.lease_timeout_ms, false);
+        stats.leases_granted++;
+        return "STALE_LEASE " + std::to_string(token) + " " + value;
+    }
+    stats.misses++;
+    
+    auto lease = leases.find(key);
+    if (lease != leases.end() && lease->second.expires_ms > now) {
+        stats.lease_waits++;
+        return "WAIT";
+    }
+    
+    // Fillers that never come back must not pin the table
+    if (leases.size() >= MAX_FILL_LEASES) {
+        for (auto l = leases.begin(); l != leases.end();) {
+            l = l->second.expires_ms <= now ? leases.erase(l) : std::next(l);
+        }
+    }
+    
+    uint64_t token = ++lease_counter;
+    leases[key] = FillLease(token, now + config.lease_timeout_ms, true);
+    stats.leases_granted++;
+    return "LEASE " + std::to_string(token);
+}
+
+std::string CacheServerDefrag::leaseSetKey(const std::string& key, const std::string& value, 
+                                           uint64_t token, const std::string& client_id, double cost) {
+    // Store a fill only while its lease is current. The check, the store
+    // and the release happen in one hold of cache_mutex, so a duplicate
+    // fill or a DELETE/UPDATE that invalidates the lease cannot interleave.
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto lease = leases.find(key);
+    if (lease == leases.end() || lease->second.token != token) {
+        stats.lease_rejects++;
+        return "NOT_STORED";
+    }
+    bool on_miss = lease->second.on_miss;
+    leases.erase(lease);
+    
+    if (findLiveEntry(key, nowMs())) {
+        if (!storeValue(key, value)) {
+            return "ERROR: Out of memory";
+        }
+        stats.updates++;
+    } else {
+        if (!allocatePages(key, value.size(), client_id)) {
+            return "ERROR: Out of memory";
+        }
+        CacheEntry& entry = entries[key];
+        writeToPages(entry.start_page, value);
+        sealEntry(entry);
+        stats.adds++;
+    }
+    updatePolicy(key);
+    
+    // A stale refresh was already counted in bytes_hit when it was served
+    if (on_miss) {
+        stats.bytes_filled += value.size();
+    }
+    applyCostHint(key, cost);
+    
+    // A refill starts a fresh TTL period
+    armDeadlines(entries[key]);
+    return "OK";
+}
+
+void CacheServerDefrag::invalidateLease(const std::string& key) {
+    // A DELETE or UPDATE while a fill is in flight makes that fill stale.
+    // Caller holds cache_mutex.
+    leases.erase(key);
+    invalidateReplica(key);
+}
+
+// Expiry and Stale-While-Revalidate
+
+std::string CacheServerDefrag::expireKey(const std::string& key, uint64_t soft_ttl_ms, 
+                                         uint64_t hard_ttl_ms, const std::string& client_id) {
+    // A TTL of 0 clears that deadline. The hard deadline is never earlier
+    // than the soft one, so stale data is always served before removal.
+    (void)client_id;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    
+    // An entry already past its hard deadline cannot be revived
+    CacheEntry* found = findLiveEntry(key, nowMs());
+    if (!found) {
+        return "NOT_FOUND";
+    }
+    
+    CacheEntry& entry = *found;
+    if (hard_ttl_ms != 0 && hard_ttl_ms < soft_ttl_ms) {
+        hard_ttl_ms = soft_ttl_ms;
+    }
+    entry.soft_ttl_ms = soft_ttl_ms;
+    entry.hard_ttl_ms = hard_ttl_ms;
+    armDeadlines(entry);
+    return "OK";
+}
+
+void CacheServerDefrag::armDeadlines(CacheEntry& entry) {
+    // Deadlines count from now. Caller holds cache_mutex.
+    uint64_t now = nowMs();
+    entry.soft_deadline_ms = entry.soft_ttl_ms ? now + entry.soft_ttl_ms : 0;
+    entry.hard_deadline_ms = entry.hard_ttl_ms ? now + entry.hard_ttl_ms : 0;
+    if (entry.hard_deadline_ms != 0) {
+        expiry_index.emplace(entry.hard_deadline_ms, entry.key);
+    }
+    
+    // Replicas skip the freshness check, so a key with a deadline loses them
+    if (entry.soft_deadline_ms != 0 || entry.hard_deadline_ms != 0) {
+        invalidateReplica(entry.key);
+        replicated_keys.erase(entry.key);
+    }
+}
+
+CacheEntry* CacheServerDefrag::findLiveEntry(const std::string& key, uint64_t now) {
+    // Lookup for every read and modify path: an entry past its hard
+    // deadline is removed and reported missing. Caller holds cache_mutex.
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    if (it->second.hard_deadline_ms != 0 && it->second.hard_deadline_ms <= now) {
+        removeEntry(key);
+        stats.expired_reaped++;
+        return nullptr;
+    }
+    return &it->second;
+}
+
+size_t CacheServerDefrag::reapExpired() {
+    // Remove every entry whose hard deadline has passed. Index records left
+    // behind by a re-EXPIRE or DELETE no longer match and are dropped.
+    // Caller holds cache_mutex.
+    uint64_t now = nowMs();
+    size_t reaped = 0;
+    while (!expiry_index.empty() && expiry_index.begin()->first <= now) {
+        auto record = expiry_index.begin();
+        auto it = entries.find(record->second);
+        if (it != entries.end() && it->second.hard_deadline_ms == record->first) {
+            removeEntry(record->second);
+            reaped++;
+        }
+        expiry_index.erase(record);
+    }
+    
+    if (reaped > 0) {
+        stats.expired_reaped += reaped;
+        std::cout << "[EXPIRY] Reaped " << reaped << " expired entries" << std::endl;
+    }
+    return reaped;
+}
+
+void CacheServerDefrag::removeEntry(const std::string& key) {
+    // Caller holds cache_mutex
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+    removeFromPolicy(it->second);
+    invalidateReplica(key);
+    freePages(key);
+    entries.erase(it);
+}
+
+void CacheServerDefrag::removeFromPolicy(CacheEntry& entry) {
+    switch (policy) {
+        case EvictionPolicy::LRU:
+            lru_list.erase(entry.lru_iter);
+            break;
+        case EvictionPolicy::SIEVE:
+            // The hand walks from tail to head
+            if (sieve_hand == entry.lru_iter) {
+                sieve_hand = sieve_hand == sieve_list.begin() ? sieve_list.end() : std::prev(sieve_hand);
+            }
+            sieve_list.erase(entry.lru_iter);
+            break;
+        case EvictionPolicy::CLOCK: {
+            // Swap the last slot into the hole so positions stay dense
+            size_t pos = entry.clock_position;
+            if (pos + 1 != clock_list.size()) {
+                clock_list[pos] = clock_list.back();
+                entries[clock_list[pos]].clock_position = pos;
+            }
+            clock_list.pop_back();
+            if (clock_hand >= clock_list.size()) {
+                clock_hand = 0;
+            }
+            break;
+        }
+        case EvictionPolicy::FIFO:
+            // The queue skips keys that are no longer cached
+            break;
+        case EvictionPolicy::GDS:
+        case EvictionPolicy::GDSF:
+            if (entry.gds_queued) {
+                gds_queue.erase(entry.gds_iter);
+                entry.gds_queued = false;
+            }
+            break;
+    }
+}
+
+// Batch Eviction
+
+bool CacheServerDefrag::selectVictim(std::string& key) {
+    // Next victim under the active policy. The caller unlinks it with
+    // removeFromPolicy before asking for another.
+    switch (policy) {
+        case EvictionPolicy::LRU:
+            if (lru_list.empty()) return false;
+            key = lru_list.back();
+            return true;
+        case EvictionPolicy::FIFO:
+            while (!fifo_queue.empty()) {
+                key = fifo_queue.front();
+                fifo_queue.pop();
+                if (entries.count(key)) return true;
+            }
+            return false;
+        case EvictionPolicy::SIEVE:
+            // Walk from the tail toward the head, clearing visited bits
+            if (sieve_list.empty()) return false;
+            while (true) {
+                if (sieve_hand == sieve_list.end()) {
+                    sieve_hand = std::prev(sieve_list.end());
+                }
+                CacheEntry& entry = entries[*sieve_hand];
+                if (!entry.visited) {
+                    key = *sieve_hand;
+                    return true;
+                }
+                entry.visited = false;
+                sieve_hand = sieve_hand == sieve_list.begin() ? sieve_list.end() : std::prev(sieve_hand);
+            }
+        case EvictionPolicy::CLOCK:
+            if (clock_list.empty()) return false;
+            while (true) {
+                if (clock_hand >= clock_list.size()) {
+                    clock_hand = 0;
+                }
+                CacheEntry& entry = entries[clock_list[clock_hand]];
+                if (!entry.reference_bit) {
+                    key = clock_list[clock_hand];
+                    return true;
+                }
+                entry.reference_bit = false;
+                clock_hand++;
+            }
+        case EvictionPolicy::GDS:
+        case EvictionPolicy::GDSF:
+            if (gds_queue.empty()) return false;
+            gds_inflation = gds_queue.begin()->first;
+            key = gds_queue.begin()->second;
+            return true;
+    }
+    return false;
+}
+
+bool CacheServerDefrag::evictBatch(size_t required_pages, bool contiguous) {
+    // Choose every victim first, then return all their runs to the free
+    // list in one sorted merge instead of one list walk per victim.
+    // Caller holds cache_mutex.
+    size_t target = total_free_pages >= required_pages ? required_pages 
+                                                      : required_pages - total_free_pages;
+    std::vector<std::pair<size_t, size_t>> runs;
+    size_t selected = 0;
+    std::string key;
+    
+    while (selected < target && selectVictim(key)) {
+        auto it = entries.find(key);
+        CacheEntry& entry = it->second;
+        removeFromPolicy(entry);
+        invalidateReplica(key);
+        if (config.lifetime_placement) {
+            recordLifetime(entry);
+        }
+        
+        for (size_t i = entry.start_page; i < entry.start_page + entry.num_pages; ++i) {
+            cache[i].is_free = true;
+        }
+        runs.emplace_back(entry.start_page, entry.num_pages);
+        selected += entry.num_pages;
+        
+        shadowDeallocation(key);
+        entries.erase(it);
+        stats.evictions++;
+    }
+    
+    if (runs.empty()) {
+        return false;
+    }
+    addRunsToFreeList(runs);
+    std::cout << "[EVICT BATCH] Evicted " << runs.size() << " entries (" 
+              << selected << " pages)" << std::endl;
+    
+    // The victims' runs need not be adjacent. Only probe here: the
+    // per-thread search would count a NUMA allocation that never happens.
+    if (contiguous && !findFirstFitBlock(required_pages) && 
+        total_free_pages >= required_pages) {
+        defragment(required_pages);
+    }
+    
+    assert(checkAllocatorInvariants());
+    return total_free_pages >= required_pages;
+}
+
+// GreedyDual-Size and GreedyDual-Size-Frequency
+
+void CacheServerDefrag::updateGDS(const std::string& key) {
+    // On insert and on every hit. Serves both GDS and GDSF.
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+    if (policy == EvictionPolicy::GDSF) {
+        it->second.frequency++;
+    }
+    reprioritizeGDS(it->second);
+}
+
+void CacheServerDefrag::reprioritizeGDS(CacheEntry& entry) {
+    // H = L + cost / pages, times the hit count under GDSF. Cheap-to-recompute
+    // and large entries sink toward eviction; L rises with each eviction so
+    // entries that are not touched again age out.
+    if (entry.gds_queued) {
+        gds_queue.erase(entry.gds_iter);
+    }
+    double value = entry.cost / std::max<size_t>(1, entry.num_pages);
+    if (policy == EvictionPolicy::GDSF) {
+        value *= std::max<uint64_t>(1, entry.frequency);
+    }
+    entry.gds_iter = gds_queue.emplace(gds_inflation + value, entry.key);
+    entry.gds_queued = true;
+}
+
+bool CacheServerDefrag::evictGDS(size_t required_pages) {
+    while (total_free_pages < required_pages && !gds_queue.empty()) {
+        auto victim = gds_queue.begin();
+        gds_inflation = victim->first;
+        std::string key = victim->second;
+        
+        std::cout << "[EVICT " << policyName(policy) << "] Evicting key: " << key << " (H=" << victim->first << ")" << std::endl;
+        removeEntry(key);
+        stats.evictions++;
+    }
+    return total_free_pages >= required_pages;
+}
+
+void CacheServerDefrag::applyCostHint(const std::string& key, double cost) {
+    // Caller holds cache_mutex
+    auto it = entries.find(key);
+    if (it == entries.end() || cost <= 0.0) {
+        return;
+    }
+    it->second.cost = cost;
+    if (policy == EvictionPolicy::GDS || policy == EvictionPolicy::GDSF) {
+        reprioritizeGDS(it->second);
+    }
+}
+
+// Pipelined GETs with group prefetching
+
+std::vector<BatchGetResult> CacheServerDefrag::getKeysBatch(const std::vector<std::string>& keys, 
+                                                            const std::string& client_id) {
+    (void)client_id;
+    std::vector<BatchGetResult> results(keys.size());
+    std::vector<CacheEntry*> found(BATCH_PREFETCH_GROUP);
+    
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    
+    // One clock reading for the batch, so a key repeated within a group
+    // cannot expire (and be removed) after an earlier lookup of it
+    uint64_t now = nowMs();
+    for (size_t group = 0; group < keys.size(); group += BATCH_PREFETCH_GROUP) {
+        size_t group_end = std::min(keys.size(), group + BATCH_PREFETCH_GROUP);
+        
+        // Pass 1: resolve every key in the group and prefetch the head of its
+        // value, so the DRAM misses of independent lookups overlap
+        for (size_t i = group; i < group_end; ++i) {
+            found[i - group] = findLiveEntry(keys[i], now);
+            if (!found[i - group]) {
+                continue;
+            }
+            
+            CacheEntry& entry = *found[i - group];
+            const uint8_t* data = cache[entry.start_page].data;
+            size_t prefetch_bytes = std::min(entry.data_size, BATCH_PREFETCH_BYTES);
+            for (size_t offset = 0; offset < prefetch_bytes; offset += 64) {
+                __builtin_prefetch(data + offset, 0, 3);
+            }
+        }
+        
+        // Pass 2: complete the lookups against warm cache lines
+        for (size_t i = group; i < group_end; ++i) {
+            stats.total_requests++;
+            CacheEntry* entry = found[i - group];
+            if (!entry) {
+                stats.misses++;
+                continue;
+            }
+            
+            // Never serve a corrupted value
+            if (!verifyEntry(*entry)) {
+                stats.misses++;
+                continue;
+            }
+            
+            stats.hits++;
+            stats.bytes_hit += entry->data_size;
+            results[i].found = true;
+            results[i].value = readFromPages(entry->start_page, entry->data_size);
+            recordAccess(*entry);
+            updatePolicy(keys[i]);
+        }
+    }
+    
+    return results;
+}
+
+// Lifetime Prediction
+
+std::string CacheServerDefrag::lifetimeClass(const std::string& key) const {
+    // Keys sharing a prefix ("session:", "user/") tend to share lifetimes
+    size_t end = key.find_first_of(":/");
+    return key.substr(0, std::min(end, (size_t)32));
+}
+
+bool CacheServerDefrag::predictShortLived(const std::string& key) {
+    auto it = lifetimes.find(lifetimeClass(key));
+    if (it == lifetimes.end() || it->second.samples < 4) {
+        return false;  // Unknown lifetimes are placed as long-lived
+    }
+    return it->second.mean_lifetime < (double)config.short_lifetime;
+}
+
+void CacheServerDefrag::recordLifetime(const CacheEntry& entry) {
+    std::string lifetime_class = lifetimeClass(entry.key);
+    auto it = lifetimes.find(lifetime_class);
+    if (it == lifetimes.end()) {
+        if (lifetimes.size() >= MAX_LIFETIME_CLASSES) {
+            // Full: forget the half sampled least recently, so abandoned
+            // prefixes age out and new ones are still learned
+            std::vector<uint64_t> sampled;
+            sampled.reserve(lifetimes.size());
+            for (const auto& pair : lifetimes) {
+                sampled.push_back(pair.second.last_sample);
+            }
+            std::nth_element(sampled.begin(), sampled.begin() + sampled.size() / 2, sampled.end());
+            uint64_t cutoff = sampled[sampled.size() / 2];
+            for (auto l = lifetimes.begin(); l != lifetimes.end();) {
+                l = l->second.last_sample <= cutoff ? lifetimes.erase(l) : std::next(l);
+            }
+        }
+        it = lifetimes.emplace(lifetime_class, LifetimeStats()).first;
+    }
+    
+    // insertion_order is the allocation counter when the entry was created
+    double observed = (double)(fifo_counter - entry.insertion_order);
+    LifetimeStats& lifetime = it->second;
+    lifetime.mean_lifetime = lifetime.samples == 0 
+        ? observed : 0.8 * lifetime.mean_lifetime + 0.2 * observed;
+    lifetime.samples++;
+    lifetime.last_sample = fifo_counter;
+}
+
+void CacheServerDefrag::printFreeList() {
+    std::cout << "\n[FREE LIST]" << std::endl;
+    std::cout << "Total free pages: " << total_free_pages << std::endl;
+    
+    int count = 0;
+    FreeBlock* current = free_list_head;
+    while (current) {
+        std::cout << "  Block " << count++ << ": "
+                  << "start=" << current->start_page << ", "
+                  << "pages=" << current->num_pages << std::endl;
+        current = current->next;
+    }
+    std::cout << "Total blocks: " << count << "\n" << std::endl;
+}
+
+void CacheServerDefrag::printFragmentationStats() {
+    FragmentationStats stats = getFragmentationStats();
     
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "FRAGMENTATION STATISTICS" << std::endl;
     std::cout << std::string(60, '=') << std::endl;
-    std::cout << "Total Free Pages:     " << stats.total_free_pages << " / " << TOTAL_PAGES 
+    size_t active_pages = activePages();
+    std::cout << "Total Free Pages:     " << stats.total_free_pages << " / " << active_pages 
               << " (" << std::fixed << std::setprecision(1) 
-              << (100.0 * stats.total_free_pages / TOTAL_PAGES) << "%)" << std::endl;
+              << (100.0 * stats.total_free_pages / active_pages) << "%)" << std::endl;
+    if (active_pages < TOTAL_PAGES) {
+        std::cout << "Retired Pages:        " << (TOTAL_PAGES - active_pages) << std::endl;
+    }
     std::cout << "Largest Free Block:   " << stats.largest_free_block << " pages" << std::endl;
     std::cout << "Number of Free Blocks: " << stats.num_free_blocks << std::endl;
     std::cout << "Fragmentation Ratio:  " << std::fixed << std::setprecision(2) 
               << (stats.fragmentation_ratio * 100) << "%" << std::endl;
     std::cout << "  (0% = no fragmentation, 100% = completely fragmented)" << std::endl;
+    
+    if (reference_allocator) {
+        FragmentationStats ref = reference_allocator->getFragmentationStats();
+        auto ops_per_sec = [](uint64_t ops, uint64_t nanos) {
+            return nanos > 0 ? ops * 1e9 / nanos : 0.0;
+        };
+        
+        std::cout << std::string(60, '-') << std::endl;
+        std::cout << "Backend              Free list     Reference" << std::endl;
+        std::cout << "Free Blocks:         " << std::setw(10) << stats.num_free_blocks 
+                  << "    " << std::setw(10) << ref.num_free_blocks << std::endl;
+        std::cout << "Largest Free Block:  " << std::setw(10) << stats.largest_free_block 
+                  << "    " << std::setw(10) << ref.largest_free_block << std::endl;
+        std::cout << "Fragmentation:       " << std::setw(9) << (stats.fragmentation_ratio * 100) 
+                  << "%    " << std::setw(9) << (ref.fragmentation_ratio * 100) << "%" << std::endl;
+        std::cout << "Defragmentations:    " << std::setw(10) << this->stats.defragmentations.load() 
+                  << "    " << std::setw(10) << reference_allocator->defragmentations << std::endl;
+        std::cout << "Allocations/sec:     " << std::setw(10) << std::setprecision(0)
+                  << ops_per_sec(allocator_operations, allocator_nanos) << "    " << std::setw(10) 
+                  << ops_per_sec(reference_allocator->operations, reference_allocator->nanos) << std::endl;
+        std::cout << "Mismatches:          " << differential_mismatches << std::endl;
+    }
     std::cout << std::string(60, '=') << "\n" << std::endl;
 }
 